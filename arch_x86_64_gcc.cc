@@ -870,11 +870,24 @@ namespace
 
     void _align_to_byte();
 
+    void _check_native();
+    void _leave_native();
+
+    static uhwi _native_align(const uhwi pos,
+			      const mpa::limbs::size_type align_log2) noexcept;
+
     const arch_x86_64_gcc &_arch;
     mpa::limbs _offset;
     mpa::limbs _bitpos;
     mpa::limbs::size_type _record_align_ffs;
     bool _is_size_constant;
+
+    // As long as the layout stays well within the range of native
+    // integers, the current position gets tracked in bits in
+    // _native_pos rather than in _offset and _bitpos.
+    static constexpr mpa::limbs::size_type _native_max_log2 = 60;
+    bool _is_native;
+    uhwi _native_pos;
   };
 }
 
@@ -884,7 +897,7 @@ record_layout_info(const arch_x86_64_gcc &arch,
   : _arch(arch), _offset(0), _bitpos(),
     _record_align_ffs(std::max(static_cast<mpa::limbs::size_type>(4),
 			       user_align_ffs + 3)),
-    _is_size_constant(true)
+    _is_size_constant(true), _is_native(true), _native_pos(0)
 {
   // c.f. start_record_layout()
 }
@@ -958,6 +971,10 @@ _update_alignment_for_bitfield(const struct_or_union_content::member &m,
 
 void record_layout_info::_normalize()
 {
+  // The native position is always normalized.
+  if (_is_native)
+    return;
+
   // Split the bit position into a byte offset and a bit position.
   if (_bitpos.is_any_set_at_or_above(3)) {
     mpa::limbs offset_add = _bitpos;
@@ -970,6 +987,11 @@ void record_layout_info::_normalize()
 
 void record_layout_info::_align_to_byte()
 {
+  if (_is_native) {
+    _native_pos = _native_align(_native_pos, 3);
+    return;
+  }
+
   if (!_bitpos)
     return;
 
@@ -978,6 +1000,31 @@ void record_layout_info::_align_to_byte()
   _bitpos = mpa::limbs::from_size_type(0);
 }
 
+void record_layout_info::_check_native()
+{
+  if (_is_native && (_native_pos >> _native_max_log2))
+    _leave_native();
+}
+
+void record_layout_info::_leave_native()
+{
+  if (!_is_native)
+    return;
+
+  _offset = mpa::limbs::from_size_type(_native_pos >> 3);
+  _bitpos = mpa::limbs::from_size_type(_native_pos & 7);
+  _is_native = false;
+}
+
+uhwi record_layout_info::_native_align(const uhwi pos,
+				       const mpa::limbs::size_type align_log2)
+  noexcept
+{
+  assert(align_log2 <= _native_max_log2);
+  const uhwi mask = (static_cast<uhwi>(1) << align_log2) - 1;
+  return (pos + mask) & ~mask;
+}
+
 bool record_layout_info::
 _excess_unit_span(const hwi byte_offset, const hwi bit_offset,
 		  const hwi size, const mpa::limbs::size_type align_log2,
@@ -1012,7 +1059,13 @@ void record_layout_info::place_struct_field(struct_or_union_content::member &m)
   assert(desired_align_ffs == 1 || desired_align_ffs >= 4);
   if (desired_align_ffs >= 3 + 1) {
     _align_to_byte();
-    _offset = _offset.align(desired_align_ffs - 1 - 3);
+    if (_is_native && desired_align_ffs - 1 <= _native_max_log2) {
+      _native_pos = _native_align(_native_pos, desired_align_ffs - 1);
+      _check_native();
+    } else {
+      _leave_native();
+      _offset = _offset.align(desired_align_ffs - 1 - 3);
+    }
   }
 
   // From gcc: Handle compatibility with PCC.  Note that if the record
@@ -1024,7 +1077,8 @@ void record_layout_info::place_struct_field(struct_or_union_content::member &m)
 	 if (!bf_t.is_packed() &&
 	     bf_t.get_width(_arch) &&
 	     bf_t.get_width(_arch) <= std::numeric_limits<uhwi>::max() &&
-	     _is_size_constant && _offset.fits_into_type<uhwi>() &&
+	     _is_size_constant &&
+	     (_is_native || _offset.fits_into_type<uhwi>()) &&
 	     (bf_t.get_base_type()->get_size(_arch).lshift(3)
 	      .fits_into_type<uhwi>())) {
 	   const std::shared_ptr<const returnable_int_type>& base_type =
@@ -1033,8 +1087,12 @@ void record_layout_info::place_struct_field(struct_or_union_content::member &m)
 	     3 + base_type->get_effective_alignment(_arch) + 1;
 	   const hwi field_size =
 	     crop_like_gcc<hwi>(static_cast<uhwi>(bf_t.get_width(_arch)));
-	   const hwi offset = crop_like_gcc<hwi>(_offset.to_type<uhwi>());
-	   const hwi bit_offset = crop_like_gcc<hwi>(_bitpos.to_type<uhwi>());
+	   const hwi offset =
+	     crop_like_gcc<hwi>(_is_native ?
+				_native_pos >> 3 : _offset.to_type<uhwi>());
+	   const hwi bit_offset =
+	     crop_like_gcc<hwi>(_is_native ?
+				_native_pos & 7 : _bitpos.to_type<uhwi>());
 	   const uhwi type_size =
 	     base_type->get_size(_arch).lshift(3).to_type<uhwi>();
 
@@ -1043,7 +1101,15 @@ void record_layout_info::place_struct_field(struct_or_union_content::member &m)
 	   // necessary.
 	   if (_excess_unit_span(offset, bit_offset, field_size,
 				 type_align_ffs - 1, type_size)) {
-	     _bitpos = _bitpos.align(type_align_ffs - 1);
+	     if (_is_native && type_align_ffs - 1 <= _native_max_log2) {
+	       _native_pos = ((_native_pos & ~static_cast<uhwi>(7)) +
+			      _native_align(_native_pos & 7,
+					    type_align_ffs - 1));
+	       _check_native();
+	     } else {
+	       _leave_native();
+	       _bitpos = _bitpos.align(type_align_ffs - 1);
+	     }
 	   }
 	 }
        })),
@@ -1052,8 +1118,13 @@ void record_layout_info::place_struct_field(struct_or_union_content::member &m)
   // From gcc: Offset so far becomes the position of this field after
   // normalizing.
   _normalize();
-  m.set_offset(_offset);
-  m.set_bitpos(_bitpos);
+  if (_is_native) {
+    m.set_offset(mpa::limbs::from_size_type(_native_pos >> 3));
+    m.set_bitpos(mpa::limbs::from_size_type(_native_pos & 7));
+  } else {
+    m.set_offset(_offset);
+    m.set_bitpos(_bitpos);
+  }
   m.set_has_constant_offset(_is_size_constant);
 
   handle_types<void>
@@ -1069,13 +1140,28 @@ void record_layout_info::place_struct_field(struct_or_union_content::member &m)
 	   _is_size_constant = false;
 
 	 } else {
-	   _bitpos = _bitpos + o_t.get_size(_arch).lshift(3);
-	   _normalize();
+	   const mpa::limbs size = o_t.get_size(_arch);
+	   if (_is_native &&
+	       !size.is_any_set_at_or_above(_native_max_log2 - 3)) {
+	     _native_pos += size.to_type<uhwi>() << 3;
+	     _check_native();
+	   } else {
+	     _leave_native();
+	     _bitpos = _bitpos + size.lshift(3);
+	     _normalize();
+	   }
 	 }
        },
        [&](const bitfield_type &bf_t) {
-	 _bitpos = _bitpos + mpa::limbs::from_size_type(bf_t.get_width(_arch));
-	 _normalize();
+	 const mpa::limbs::size_type width = bf_t.get_width(_arch);
+	 if (_is_native && !(width >> _native_max_log2)) {
+	   _native_pos += width;
+	   _check_native();
+	 } else {
+	   _leave_native();
+	   _bitpos = _bitpos + mpa::limbs::from_size_type(width);
+	   _normalize();
+	 }
        })),
      *t);
 }
@@ -1118,22 +1204,37 @@ void record_layout_info::place_union_field(struct_or_union_content::member &m)
 	 })),
        *t);
 
-  if (_offset < size)
-    _offset = std::move(size);
+  if (_is_native && !size.is_any_set_at_or_above(_native_max_log2 - 3)) {
+    _native_pos = std::max(_native_pos, size.to_type<uhwi>() << 3);
+  } else {
+    _leave_native();
+    if (_offset < size)
+      _offset = std::move(size);
+  }
 }
 
 void record_layout_info::finish_record_layout(struct_or_union_content &sc)
 {
-  _normalize();
+  if (_record_align_ffs - 1 > _native_max_log2)
+    _leave_native();
 
-  const mpa::limbs unpadded_size = _offset.lshift(3) + _bitpos;
-  const mpa::limbs type_size = unpadded_size.align(_record_align_ffs - 1);
-  assert(!type_size.is_any_set_below(3));
+  mpa::limbs size;
+  if (_is_native) {
+    const uhwi type_size = _native_align(_native_pos, _record_align_ffs - 1);
+    size = mpa::limbs::from_size_type(type_size >> 3);
+  } else {
+    _normalize();
+
+    const mpa::limbs unpadded_size = _offset.lshift(3) + _bitpos;
+    const mpa::limbs type_size = unpadded_size.align(_record_align_ffs - 1);
+    assert(!type_size.is_any_set_below(3));
+    size = type_size.rshift(3, false);
+  }
 
   assert(_record_align_ffs >= 4);
   sc.set_alignment(_record_align_ffs - 3 - 1);
   if (_is_size_constant) {
-    sc.set_size(type_size.rshift(3, false));
+    sc.set_size(std::move(size));
     sc.set_size_constant(true);
   } else {
     sc.set_size_constant(false);
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <new>
+#include "arena.hh"
+
+using namespace klp::ccp;
+
+thread_local arena *arena::_current = nullptr;
+
+arena::arena() noexcept
+  : _cur(nullptr), _end(nullptr)
+{}
+
+arena::~arena() noexcept
+{
+  for (auto c : _chunks)
+    ::operator delete(c);
+}
+
+void* arena::allocate(std::size_t size)
+{
+  constexpr std::size_t align = alignof(std::max_align_t);
+  size = (size + align - 1) & ~(align - 1);
+
+  if (size > static_cast<std::size_t>(_end - _cur)) {
+    // Oversized requests get a chunk of their own and leave the
+    // current one alone.
+    if (size > _chunk_size / 4) {
+      _chunks.reserve(_chunks.size() + 1);
+      void * const c = ::operator new(size);
+      _chunks.push_back(c);
+      return c;
+    }
+
+    _chunks.reserve(_chunks.size() + 1);
+    _cur = static_cast<char *>(::operator new(_chunk_size));
+    _end = _cur + _chunk_size;
+    _chunks.push_back(_cur);
+  }
+
+  void * const p = _cur;
+  _cur += size;
+  return p;
+}
+
+
+arena::activation::activation(arena * const a) noexcept
+  : _prev(_current)
+{
+  _current = a;
+}
+
+arena::activation::~activation() noexcept
+{
+  _current = _prev;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ARENA_HH
+#define ARENA_HH
+
+#include <cstddef>
+#include <vector>
+
+namespace klp
+{
+  namespace ccp
+  {
+    // A bump pointer allocator. Memory handed out by allocate() is
+    // never freed individually, but only all at once when the arena
+    // gets destroyed.
+    class arena
+    {
+    public:
+      arena() noexcept;
+
+      arena(const arena&) = delete;
+
+      ~arena() noexcept;
+
+      arena& operator=(const arena&) = delete;
+
+      void* allocate(const std::size_t size);
+
+      // The arena allocate_current() allocates from, if any, is set
+      // for the lifetime of an activation. Activations nest.
+      class activation
+      {
+      public:
+	activation(arena * const a) noexcept;
+
+	activation(const activation&) = delete;
+
+	~activation() noexcept;
+
+      private:
+	arena *_prev;
+      };
+
+      static arena* get_current() noexcept
+      { return _current; }
+
+    private:
+      static constexpr std::size_t _chunk_size = 64 * 1024;
+
+      std::vector<void*> _chunks;
+      char *_cur;
+      char *_end;
+
+      static thread_local arena *_current;
+    };
+  }
+}
+
+#endif
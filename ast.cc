@@ -17,6 +17,9 @@
  */
 
 #include <cassert>
+#include <new>
+#include <typeindex>
+#include <unordered_map>
 #include "ast_impl.hh"
 #include "ast_processor.hh"
 #include "semantic_except.hh"
@@ -43,6 +46,38 @@ _ast_entity::_ast_entity(const _ast_entity &ae) noexcept
 
 _ast_entity::~_ast_entity() noexcept = default;
 
+namespace
+{
+  // Each node is preceded by a header telling whether it has been
+  // allocated from an arena or from the heap. Arena allocations are
+  // released only in bulk, when the arena goes away.
+  union _alloc_header
+  {
+    bool from_arena;
+    std::max_align_t align;
+  };
+}
+
+void* _ast_entity::operator new(const std::size_t size)
+{
+  arena * const a = arena::get_current();
+  const std::size_t total = sizeof(_alloc_header) + size;
+  void * const p = a ? a->allocate(total) : ::operator new(total);
+  _alloc_header * const h = new (p) _alloc_header;
+  h->from_arena = !!a;
+  return h + 1;
+}
+
+void _ast_entity::operator delete(void * const p) noexcept
+{
+  if (!p)
+    return;
+
+  _alloc_header * const h = static_cast<_alloc_header *>(p) - 1;
+  if (!h->from_arena)
+    ::operator delete(h);
+}
+
 void _ast_entity::_extend_tokens_range(const pp_tokens_range &tr) noexcept
 {
   assert(_tokens_range.end <= tr.begin);
@@ -7851,12 +7886,51 @@ bool translation_unit::_process(const_processor<bool> &p) const
 }
 
 
+_dfs_index::_dfs_index(_ast_entity &root)
+{
+  std::unordered_map<std::type_index, std::uint32_t> kinds;
+  auto &&get_kind = [&](_ast_entity &ae) -> std::uint32_t {
+    auto it = kinds.find(typeid(ae));
+    if (it != kinds.end())
+      return it->second;
+
+    const std::uint32_t kind = _kinds.size();
+    kinds.insert(std::make_pair(std::type_index(typeid(ae)), kind));
+    _kinds.push_back(&ae);
+    _kinds_po.emplace_back();
+    return kind;
+  };
+
+  // The positions within _entries of the current node's ancestors
+  // and the index of their respective next child to visit.
+  std::vector<std::pair<std::uint32_t, std::size_t>> stack;
+
+  _entries.push_back(_entry{&root, 0, get_kind(root)});
+  stack.emplace_back(0, 0);
+  while (!stack.empty()) {
+    const std::uint32_t i = stack.back().first;
+    _ast_entity * const child =
+      _entries[i].ae->_get_child(stack.back().second++);
+    if (child) {
+      stack.emplace_back(_entries.size(), 0);
+      _entries.push_back(_entry{child, 0, get_kind(*child)});
+    } else {
+      _entries[i].end = _entries.size();
+      _kinds_po[_entries[i].kind].push_back(_po.size());
+      _po.push_back(i);
+      stack.pop_back();
+    }
+  }
+}
+
+
 ast::ast(const pp_result &pp_result, const bool is_pp_expr)
   : _pp_result(pp_result), _is_pp_expr(is_pp_expr)
 {}
 
 ast::ast(ast &&a)
-  : _pp_result(a._pp_result), _is_pp_expr(a._is_pp_expr)
+  : _pp_result(a._pp_result), _is_pp_expr(a._is_pp_expr),
+    _constexpr_memo(std::move(a._constexpr_memo))
 {}
 
 ast::~ast() noexcept = default;
@@ -7866,21 +7940,46 @@ const klp::ccp::pp_tokens& ast::get_pp_tokens() const noexcept
   return _pp_result.get_pp_tokens();
 }
 
+const ast::constexpr_memo_entry*
+ast::lookup_constexpr_memo(const constexpr_memo_key &key) const noexcept
+{
+  const auto it = _constexpr_memo.find(key);
+  if (it == _constexpr_memo.end())
+    return nullptr;
+  return &it->second;
+}
+
+void ast::add_constexpr_memo(constexpr_memo_key &&key,
+			     constexpr_memo_entry &&entry)
+{
+  _constexpr_memo.emplace(std::move(key), std::move(entry));
+}
+
 
 ast_translation_unit::
 ast_translation_unit(std::unique_ptr<const pp_result> &&pp_result,
+		     std::unique_ptr<arena> &&a,
 		     std::unique_ptr<translation_unit> &&tu)
   : ast(*pp_result, false), _pp_result(std::move(pp_result)),
-    _tu(std::move(tu))
+    _arena(std::move(a)), _tu(std::move(tu))
 {}
 
 ast_translation_unit::ast_translation_unit(ast_translation_unit &&a)
   : ast(std::move(a)), _pp_result(std::move(a._pp_result)),
-    _tu(std::move(a._tu))
+    _arena(std::move(a._arena)), _tu(std::move(a._tu)),
+    _dfs_idx(std::move(a._dfs_idx))
 {}
 
 ast_translation_unit::~ast_translation_unit() noexcept = default;
 
+_dfs_index& ast_translation_unit::_get_dfs_index() const
+{
+  // The tree doesn't change anymore once parsing has finished.
+  if (!_dfs_idx)
+    _dfs_idx.reset(new _dfs_index(*_tu));
+  return *_dfs_idx;
+}
+
 
 ast_pp_expr::ast_pp_expr(const pp_result &pp_result,
 			 std::unique_ptr<expr> &&e)
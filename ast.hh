@@ -20,7 +20,11 @@
 #define AST_HH
 
 #include <vector>
+#include <map>
+#include <tuple>
+#include <string>
 #include <cassert>
+#include <cstdint>
 #include <initializer_list>
 #include <functional>
 #include <memory>
@@ -32,6 +36,7 @@
 #include "builtins.hh"
 #include "pp_tokens_range.hh"
 #include "pp_result.hh"
+#include "arena.hh"
 
 namespace klp
 {
@@ -51,6 +56,11 @@ namespace klp
 
       class ast;
 
+      // Key for memoized constant expression evaluations: the kind of
+      // expression, the identity of the type involved, if any, and
+      // the relevant spelling.
+      typedef std::tuple<char, const void*, std::string> constexpr_memo_key;
+
       template<typename derived>
       class ast_entity;
 
@@ -63,6 +73,11 @@ namespace klp
 
 	virtual ~_ast_entity() noexcept;
 
+	// AST nodes get allocated from the currently active arena, if
+	// any, and fall back to the heap otherwise.
+	static void* operator new(const std::size_t size);
+	static void operator delete(void * const p) noexcept;
+
 	const pp_tokens_range& get_tokens_range() const noexcept
 	{ return _tokens_range; }
 
@@ -113,6 +128,8 @@ namespace klp
 	template<typename derived>
 	friend class ast_entity;
 
+	friend class _dfs_index;
+
 	virtual _ast_entity* _get_child(const size_t i) const noexcept = 0;
 
 	virtual void _process(processor<void> &p) = 0;
@@ -490,6 +507,11 @@ namespace klp
 
 	void _convert_type_for_expr_context();
 
+	bool _reuse_memoized(const ast &a, const constexpr_memo_key &key);
+	void _memoize(ast &a, constexpr_memo_key &&key,
+		      const std::shared_ptr<const types::type> &key_type)
+	  const;
+
       private:
 	std::unique_ptr<constexpr_value> _value;
 	bool _is_lvalue;
@@ -809,6 +831,8 @@ namespace klp
 	{ return _tn; }
 
       private:
+	void _evaluate_type(ast &a, const architecture &arch);
+
 	virtual _ast_entity* _get_child(const size_t i) const noexcept override;
 
 	virtual void _process(processor<void> &p) override;
@@ -853,6 +877,8 @@ namespace klp
 	{ return _tn; }
 
       private:
+	void _evaluate_type(ast &a, const architecture &arch);
+
 	virtual _ast_entity* _get_child(const size_t i) const noexcept override;
 
 	virtual void _process(processor<void> &p) override;
@@ -948,6 +974,8 @@ namespace klp
 	{ return _tn; }
 
       private:
+	void _evaluate_type(ast &a, const architecture &arch);
+
 	virtual _ast_entity* _get_child(const size_t i) const noexcept override;
 
 	virtual void _process(processor<void> &p) override;
@@ -1284,6 +1312,8 @@ namespace klp
 	virtual void evaluate_type(ast &a, const architecture &arch) override;
 
       private:
+	void _evaluate_type(ast &a, const architecture &arch);
+
 	virtual _ast_entity* _get_child(const size_t) const noexcept override;
 
 	virtual void _process(processor<void> &p) override;
@@ -4628,6 +4658,68 @@ namespace klp
       };
 
 
+      // A flattened, pre-ordered view of an AST, built once and used
+      // in place of the recursion through _ast_entity::_get_child()
+      // for subsequent traversals. Each node is tagged with a kind
+      // identifying its dynamic type. Traversals handling only a few
+      // types translate these kinds once into the index of the
+      // respective handled type and dispatch through that table.
+      class _dfs_index
+      {
+      public:
+	_dfs_index(_ast_entity &root);
+
+	template <typename handled_types_pre,
+		  typename handled_types_post,
+		  typename callables_wrapper_type_pre,
+		  typename callables_wrapper_type_post>
+	void for_each_dfs_pre_and_po(callables_wrapper_type_pre &&c_pre,
+				     callables_wrapper_type_post &&c_post);
+
+	template <typename handled_types_pre,
+		  typename handled_types_post,
+		  typename callables_wrapper_type_pre,
+		  typename callables_wrapper_type_post>
+	void for_each_dfs_pre_and_po(callables_wrapper_type_pre &&c_pre,
+				     callables_wrapper_type_post &&c_post)
+	  const;
+
+	template <typename handled_types, typename callables_wrapper_type>
+	void for_each_dfs_po(callables_wrapper_type &&c);
+
+	// Invoke c in post-order only on those nodes which are of any
+	// of the handled_types, skipping all others entirely.
+	template <typename handled_types, typename callables_wrapper_type>
+	void for_each_of(callables_wrapper_type &&c);
+
+      private:
+	struct _entry
+	{
+	  _ast_entity *ae;
+	  // One past the last descendant's position in pre-order.
+	  std::uint32_t end;
+	  std::uint32_t kind;
+	};
+
+	template <typename handled_types>
+	std::vector<std::size_t> _match_kinds() const;
+
+	template <typename entity_type,
+		  typename callable_type_pre,
+		  typename callable_type_post>
+	void _walk_pre_and_po(callable_type_pre &&c_pre,
+			      callable_type_post &&c_post) const;
+
+	std::vector<_entry> _entries;
+	// Positions within _entries in post-order.
+	std::vector<std::uint32_t> _po;
+	// One node of each kind, for determining the kinds' types.
+	std::vector<_ast_entity*> _kinds;
+	// For each kind, the nodes' ranks within _po.
+	std::vector<std::vector<std::uint32_t>> _kinds_po;
+      };
+
+
       class ast
       {
       public:
@@ -4648,16 +4740,34 @@ namespace klp
 	bool is_pp_expr() const noexcept
 	{ return _is_pp_expr; }
 
+	// Results of constant subexpressions which occur over and over
+	// again, e.g. from macro expansions, get evaluated only once.
+	struct constexpr_memo_entry
+	{
+	  // Keeps the type identified by the key alive.
+	  std::shared_ptr<const types::type> key_type;
+	  std::shared_ptr<const types::type> type;
+	  std::unique_ptr<constexpr_value> value;
+	};
+
+	const constexpr_memo_entry*
+	lookup_constexpr_memo(const constexpr_memo_key &key) const noexcept;
+
+	void add_constexpr_memo(constexpr_memo_key &&key,
+				constexpr_memo_entry &&entry);
+
       private:
 	const pp_result &_pp_result;
 	code_remarks _remarks;
 	bool _is_pp_expr;
+	std::map<constexpr_memo_key, constexpr_memo_entry> _constexpr_memo;
       };
 
       class ast_translation_unit final : public ast
       {
       public:
 	ast_translation_unit(std::unique_ptr<const pp_result> &&pp_result,
+			     std::unique_ptr<arena> &&a,
 			     std::unique_ptr<translation_unit> &&tu);
 
 	ast_translation_unit(ast_translation_unit &&a);
@@ -4667,6 +4777,9 @@ namespace klp
 	template <typename handled_types, typename callables_wrapper_type>
 	void for_each_dfs_po(callables_wrapper_type &&c);
 
+	template <typename handled_types, typename callables_wrapper_type>
+	void for_each_of(callables_wrapper_type &&c);
+
 	template <typename handled_types_pre,
 		  typename handled_types_post,
 		  typename callables_wrapper_type_pre,
@@ -4694,8 +4807,14 @@ namespace klp
 
 	void _resolve_ids(const architecture &arch);
 
+	_dfs_index& _get_dfs_index() const;
+
 	std::unique_ptr<const pp_result> _pp_result;
+	// The nodes of _tu live in _arena, hence the latter must get
+	// destroyed last.
+	std::unique_ptr<arena> _arena;
 	std::unique_ptr<translation_unit> _tu;
+	mutable std::unique_ptr<_dfs_index> _dfs_idx;
       };
 
       class ast_pp_expr final : public ast
@@ -55,6 +55,10 @@ namespace
 	       klp::ccp::ast::_ast_entity &ae,
 	       const architecture &arch) noexcept;
 
+    _evaluator(klp::ccp::ast::ast_translation_unit &atu,
+	       klp::ccp::ast::_ast_entity &ae,
+	       const architecture &arch) noexcept;
+
     void operator()();
 
   private:
@@ -63,6 +67,8 @@ namespace
     _check_function_definition(const klp::ccp::ast::function_definition &fd);
 
     klp::ccp::ast::ast &_ast;
+    // Traversals of whole translation units go through their index.
+    klp::ccp::ast::ast_translation_unit * const _atu;
     klp::ccp::ast::_ast_entity &_ae;
     const architecture &_arch;
   };
@@ -71,7 +77,13 @@ namespace
 _evaluator::_evaluator(klp::ccp::ast::ast &ast,
 		       klp::ccp::ast::_ast_entity &ae,
 		       const architecture &arch) noexcept
-  : _ast(ast), _ae(ae), _arch(arch)
+  : _ast(ast), _atu(nullptr), _ae(ae), _arch(arch)
+{}
+
+_evaluator::_evaluator(klp::ccp::ast::ast_translation_unit &atu,
+		       klp::ccp::ast::_ast_entity &ae,
+		       const architecture &arch) noexcept
+  : _ast(atu), _atu(&atu), _ae(ae), _arch(arch)
 {}
 
 void _evaluator::operator()()
@@ -145,23 +157,30 @@ void _evaluator::operator()()
 	t.evaluate_type(_ast, _arch);
      }));
 
-  _ae.for_each_dfs_pre_and_po<type_set<abstract_declarator,
-				       direct_abstract_declarator,
-				       declarator,
-				       direct_declarator,
-				       enumerator,
-				       init_declarator,
-				       parameter_declaration_abstract,
-				       stmt_return,
-				       function_definition,
-				       _typed>,
-			      type_set<enumerator,
-				       init_declarator,
-				       parameter_declaration_abstract,
-				       stmt_return,
-				       function_definition,
-				       _typed> >
-    (std::move(pre), std::move(post));
+  typedef type_set<abstract_declarator,
+		   direct_abstract_declarator,
+		   declarator,
+		   direct_declarator,
+		   enumerator,
+		   init_declarator,
+		   parameter_declaration_abstract,
+		   stmt_return,
+		   function_definition,
+		   _typed> handled_types_pre;
+  typedef type_set<enumerator,
+		   init_declarator,
+		   parameter_declaration_abstract,
+		   stmt_return,
+		   function_definition,
+		   _typed> handled_types_post;
+
+  if (_atu) {
+    _atu->for_each_dfs_pre_and_po<handled_types_pre, handled_types_post>
+      (std::move(pre), std::move(post));
+  } else {
+    _ae.for_each_dfs_pre_and_po<handled_types_pre, handled_types_post>
+      (std::move(pre), std::move(post));
+  }
 }
 
 void _evaluator::_check_return_stmt(const klp::ccp::ast::stmt_return &ret_stmt)
@@ -3101,6 +3120,47 @@ void expr::_convert_type_for_expr_context()
 }
 
 
+bool expr::_reuse_memoized(const ast &a, const constexpr_memo_key &key)
+{
+  const ast::constexpr_memo_entry * const entry = a.lookup_constexpr_memo(key);
+  if (!entry)
+    return false;
+
+  _set_type(entry->type);
+  if (entry->value)
+    _set_value(entry->value->clone());
+  return true;
+}
+
+void expr::_memoize(ast &a, constexpr_memo_key &&key,
+		    const std::shared_ptr<const types::type> &key_type) const
+{
+  a.add_constexpr_memo(std::move(key),
+		       ast::constexpr_memo_entry{
+			 key_type, get_type(),
+			 _value ? _value->clone() : nullptr});
+}
+
+static const void* _constexpr_memo_type_id(const type &t)
+{
+  // Struct and union types referring to the same definition have
+  // the same size and alignment, unless some alignment has been
+  // attached to the type itself. All other types are identified by
+  // the type object.
+  return (handle_types<const void*>
+	  ((wrap_callables<default_action_nop>
+	    ([&](const struct_or_union_type &sout) -> const void* {
+	       if (sout.get_user_alignment().is_set() || !sout.is_complete())
+		 return &sout;
+	       return sout.get_content();
+	     },
+	     [&](const type &_t) -> const void* {
+	       return &_t;
+	     })),
+	   t));
+}
+
+
 void expr_comma::evaluate_type(ast&, const architecture&)
 {
   _set_type(_right.get_type());
@@ -5526,7 +5586,7 @@ void expr_sizeof_expr::evaluate_type(ast &a, const architecture &arch)
 }
 
 
-void expr_sizeof_type_name::evaluate_type(ast &a, const architecture &arch)
+void expr_sizeof_type_name::_evaluate_type(ast &a, const architecture &arch)
 {
     handle_types<void>
       ((wrap_callables<default_action_unreachable<void, type_set<> >::type>
@@ -5568,6 +5628,17 @@ void expr_sizeof_type_name::evaluate_type(ast &a, const architecture &arch)
        *_tn.get_type());
 }
 
+void expr_sizeof_type_name::evaluate_type(ast &a, const architecture &arch)
+{
+  const std::shared_ptr<const addressable_type> &t = _tn.get_type();
+  constexpr_memo_key key{'s', _constexpr_memo_type_id(*t), std::string{}};
+  if (_reuse_memoized(a, key))
+    return;
+
+  _evaluate_type(a, arch);
+  _memoize(a, std::move(key), t);
+}
+
 
 void expr_alignof_expr::evaluate_type(ast &a, const architecture &arch)
 {
@@ -5615,7 +5686,7 @@ void expr_alignof_expr::evaluate_type(ast &a, const architecture &arch)
 }
 
 
-void expr_alignof_type_name::evaluate_type(ast &a, const architecture &arch)
+void expr_alignof_type_name::_evaluate_type(ast &a, const architecture &arch)
 {
     handle_types<void>
       ((wrap_callables<default_action_unreachable<void, type_set<> >::type>
@@ -5660,8 +5731,19 @@ void expr_alignof_type_name::evaluate_type(ast &a, const architecture &arch)
        *_tn.get_type());
 }
 
+void expr_alignof_type_name::evaluate_type(ast &a, const architecture &arch)
+{
+  const std::shared_ptr<const addressable_type> &t = _tn.get_type();
+  constexpr_memo_key key{'a', _constexpr_memo_type_id(*t), std::string{}};
+  if (_reuse_memoized(a, key))
+    return;
 
-void expr_builtin_offsetof::evaluate_type(ast &a, const architecture &arch)
+  _evaluate_type(a, arch);
+  _memoize(a, std::move(key), t);
+}
+
+
+void expr_builtin_offsetof::_evaluate_type(ast &a, const architecture &arch)
 {
   const addressable_type *t_base = _tn.get_type().get();
   constexpr_value::address_constant ac;
@@ -5827,6 +5909,37 @@ void expr_builtin_offsetof::evaluate_type(ast &a, const architecture &arch)
   }
 }
 
+void expr_builtin_offsetof::evaluate_type(ast &a, const architecture &arch)
+{
+  // Only member designators without any array index expressions are
+  // fully determined by their spelling.
+  std::string designators;
+  bool memoizable = true;
+  _member_designator.for_each
+    (wrap_callables<default_action_nop>
+     ([&](const offset_member_designator::member &m) {
+	designators += m.ptr_base ? "->" : ".";
+	designators += a.get_pp_tokens()[m.member_tok].get_value();
+      },
+      [&](const expr&) {
+	memoizable = false;
+      }));
+
+  if (!memoizable) {
+    _evaluate_type(a, arch);
+    return;
+  }
+
+  const std::shared_ptr<const addressable_type> &t = _tn.get_type();
+  constexpr_memo_key key{'o', _constexpr_memo_type_id(*t),
+			 std::move(designators)};
+  if (_reuse_memoized(a, key))
+    return;
+
+  _evaluate_type(a, arch);
+  _memoize(a, std::move(key), t);
+}
+
 
 void expr_builtin_types_compatible_p::evaluate_type(ast&,
 						    const architecture &arch)
@@ -6391,7 +6504,7 @@ void expr_id::evaluate_type(ast &a, const architecture &arch)
 }
 
 
-void expr_constant::evaluate_type(ast &a, const architecture &arch)
+void expr_constant::_evaluate_type(ast &a, const architecture &arch)
 {
   const pp_token &val_tok = a.get_pp_tokens()[_const_tok];
   const std::string &val = val_tok.get_value();
@@ -6922,6 +7035,24 @@ void expr_constant::evaluate_type(ast &a, const architecture &arch)
   return;
 }
 
+void expr_constant::evaluate_type(ast &a, const architecture &arch)
+{
+  // The evaluation of character constants might emit warnings, only
+  // memoize numbers.
+  const pp_token &val_tok = a.get_pp_tokens()[_const_tok];
+  if (val_tok.get_type() != pp_token::type::pp_number) {
+    _evaluate_type(a, arch);
+    return;
+  }
+
+  constexpr_memo_key key{'c', nullptr, val_tok.get_value()};
+  if (_reuse_memoized(a, key))
+    return;
+
+  _evaluate_type(a, arch);
+  _memoize(a, std::move(key), nullptr);
+}
+
 
 void expr_string_literal::evaluate_type(ast &a, const architecture &arch)
 {
@@ -20,6 +20,7 @@
 #define AST_IMPL_HH
 
 #include <type_traits>
+#include <algorithm>
 #include "ast.hh"
 #include "ast_processor_impl.hh"
 #include "type_set.hh"
@@ -134,6 +135,67 @@ namespace klp
 	private:
 	  callable_type &&_c;
 	};
+
+	template<typename T, typename entity_type>
+	typename std::enable_if<std::is_base_of<_ast_entity, T>::value,
+				T&>::type
+	_kind_cast(entity_type &ae) noexcept
+	{
+	  return static_cast<T&>(ae);
+	}
+
+	template<typename T, typename entity_type>
+	typename std::enable_if<!std::is_base_of<_ast_entity, T>::value,
+				T&>::type
+	_kind_cast(entity_type &ae)
+	{
+	  return dynamic_cast<T&>(ae);
+	}
+
+	// Determines the first of the handled types an _ast_entity of a
+	// given dynamic type matches and invokes a callable on a node
+	// cast to the type at a given such index.
+	template<typename handled_types>
+	struct _kind_dispatcher;
+
+	template<typename T, typename... types>
+	struct _kind_dispatcher<type_set<T, types...> >
+	{
+	  static std::size_t first_match(_ast_entity &ae) noexcept
+	  {
+	    if (dynamic_cast<typename std::add_pointer<T>::type>(&ae))
+	      return 0;
+	    return 1 + _kind_dispatcher<type_set<types...> >::first_match(ae);
+	  }
+
+	  template<typename ret_type, typename callable_type,
+		   typename entity_type>
+	  static ret_type call(const std::size_t i, callable_type &c,
+			       entity_type &ae)
+	  {
+	    if (!i)
+	      return c(_kind_cast<T>(ae));
+	    return (_kind_dispatcher<type_set<types...> >::
+		    template call<ret_type>(i - 1, c, ae));
+	  }
+	};
+
+	template<>
+	struct _kind_dispatcher<type_set<> >
+	{
+	  static std::size_t first_match(_ast_entity&) noexcept
+	  {
+	    return 0;
+	  }
+
+	  template<typename ret_type, typename callable_type,
+		   typename entity_type>
+	  static ret_type call(const std::size_t, callable_type &c,
+			       entity_type &ae)
+	  {
+	    return c(ae);
+	  }
+	};
       }
 
       template <typename ret_type, typename handled_types,
@@ -406,6 +468,228 @@ namespace klp
       }
 
 
+      template <typename handled_types>
+      std::vector<std::size_t> _dfs_index::_match_kinds() const
+      {
+	std::vector<std::size_t> m;
+
+	m.reserve(_kinds.size());
+	for (auto ae : _kinds)
+	  m.push_back(impl::_kind_dispatcher<handled_types>::first_match(*ae));
+
+	return m;
+      }
+
+      template <typename entity_type,
+		typename callable_type_pre,
+		typename callable_type_post>
+      void _dfs_index::_walk_pre_and_po(callable_type_pre &&c_pre,
+					callable_type_post &&c_post) const
+      {
+	// The nodes still awaiting their post-order visit, together with
+	// what their pre-order visit returned.
+	std::vector<std::pair<std::uint32_t, bool> > pending;
+
+	const std::uint32_t n = _entries.size();
+	for (std::uint32_t i = 0;; ++i) {
+	  while (!pending.empty() && _entries[pending.back().first].end <= i) {
+	    const _entry &e = _entries[pending.back().first];
+	    const bool do_po = pending.back().second;
+	    pending.pop_back();
+	    if (do_po)
+	      c_post(static_cast<entity_type&>(*e.ae), e.kind);
+	  }
+
+	  if (i == n)
+	    break;
+
+	  const _entry &e = _entries[i];
+	  pending.emplace_back(i, c_pre(static_cast<entity_type&>(*e.ae),
+					e.kind));
+	}
+      }
+
+      template <typename handled_types_pre,
+		typename handled_types_post,
+		typename callables_wrapper_type_pre,
+		typename callables_wrapper_type_post>
+      void
+      _dfs_index::for_each_dfs_pre_and_po(callables_wrapper_type_pre &&c_pre,
+					  callables_wrapper_type_post &&c_post)
+      {
+	if (handled_types_pre::size() < impl::double_dispatch_threshold &&
+	    handled_types_post::size() < impl::double_dispatch_threshold) {
+	  const std::vector<std::size_t> m_pre =
+	    _match_kinds<handled_types_pre>();
+	  const std::vector<std::size_t> m_post =
+	    _match_kinds<handled_types_post>();
+	  auto &&_c_pre = [&](_ast_entity &ae, const std::uint32_t kind) {
+	    return (impl::_kind_dispatcher<handled_types_pre>::
+		    template call<bool>(m_pre[kind], c_pre, ae));
+	  };
+	  auto &&_c_post = [&](_ast_entity &ae, const std::uint32_t kind) {
+	    impl::_kind_dispatcher<handled_types_post>::
+	      template call<void>(m_post[kind], c_post, ae);
+	  };
+	  _walk_pre_and_po<_ast_entity>(_c_pre, _c_post);
+
+	} else if (handled_types_pre::size() <
+		   impl::double_dispatch_threshold) {
+	  const std::vector<std::size_t> m_pre =
+	    _match_kinds<handled_types_pre>();
+	  auto &&_c_pre = [&](_ast_entity &ae, const std::uint32_t kind) {
+	    return (impl::_kind_dispatcher<handled_types_pre>::
+		    template call<bool>(m_pre[kind], c_pre, ae));
+	  };
+	  auto &&processor_post = make_processor<void>(c_post);
+	  auto &&_c_post = [&processor_post](_ast_entity &ae, std::uint32_t) {
+	    ae._process(processor_post);
+	  };
+	  _walk_pre_and_po<_ast_entity>(_c_pre, _c_post);
+
+	} else if (handled_types_post::size() <
+		   impl::double_dispatch_threshold) {
+	  auto &&processor_pre = make_processor<bool>(c_pre);
+	  auto &&_c_pre = [&processor_pre](_ast_entity &ae, std::uint32_t) {
+	    return ae._process(processor_pre);
+	  };
+	  const std::vector<std::size_t> m_post =
+	    _match_kinds<handled_types_post>();
+	  auto &&_c_post = [&](_ast_entity &ae, const std::uint32_t kind) {
+	    impl::_kind_dispatcher<handled_types_post>::
+	      template call<void>(m_post[kind], c_post, ae);
+	  };
+	  _walk_pre_and_po<_ast_entity>(_c_pre, _c_post);
+
+	} else {
+	  auto &&processor_pre = make_processor<bool>(c_pre);
+	  auto &&_c_pre = [&processor_pre](_ast_entity &ae, std::uint32_t) {
+	    return ae._process(processor_pre);
+	  };
+	  auto &&processor_post = make_processor<void>(c_post);
+	  auto &&_c_post = [&processor_post](_ast_entity &ae, std::uint32_t) {
+	    ae._process(processor_post);
+	  };
+	  _walk_pre_and_po<_ast_entity>(_c_pre, _c_post);
+	}
+      }
+
+      template <typename handled_types_pre,
+		typename handled_types_post,
+		typename callables_wrapper_type_pre,
+		typename callables_wrapper_type_post>
+      void
+      _dfs_index::for_each_dfs_pre_and_po(callables_wrapper_type_pre &&c_pre,
+					  callables_wrapper_type_post &&c_post)
+	const
+      {
+	typedef typename handled_types_pre::add_const const_types_pre;
+	typedef typename handled_types_post::add_const const_types_post;
+
+	if (handled_types_pre::size() < impl::double_dispatch_threshold &&
+	    handled_types_post::size() < impl::double_dispatch_threshold) {
+	  const std::vector<std::size_t> m_pre =
+	    _match_kinds<const_types_pre>();
+	  const std::vector<std::size_t> m_post =
+	    _match_kinds<const_types_post>();
+	  auto &&_c_pre = [&](const _ast_entity &ae,
+			      const std::uint32_t kind) {
+	    return (impl::_kind_dispatcher<const_types_pre>::
+		    template call<bool>(m_pre[kind], c_pre, ae));
+	  };
+	  auto &&_c_post = [&](const _ast_entity &ae,
+			       const std::uint32_t kind) {
+	    impl::_kind_dispatcher<const_types_post>::
+	      template call<void>(m_post[kind], c_post, ae);
+	  };
+	  _walk_pre_and_po<const _ast_entity>(_c_pre, _c_post);
+
+	} else if (handled_types_pre::size() <
+		   impl::double_dispatch_threshold) {
+	  const std::vector<std::size_t> m_pre =
+	    _match_kinds<const_types_pre>();
+	  auto &&_c_pre = [&](const _ast_entity &ae,
+			      const std::uint32_t kind) {
+	    return (impl::_kind_dispatcher<const_types_pre>::
+		    template call<bool>(m_pre[kind], c_pre, ae));
+	  };
+	  auto &&processor_post = make_const_processor<void>(c_post);
+	  auto &&_c_post = [&processor_post](const _ast_entity &ae,
+					     std::uint32_t) {
+	    ae._process(processor_post);
+	  };
+	  _walk_pre_and_po<const _ast_entity>(_c_pre, _c_post);
+
+	} else if (handled_types_post::size() <
+		   impl::double_dispatch_threshold) {
+	  auto &&processor_pre = make_const_processor<bool>(c_pre);
+	  auto &&_c_pre = [&processor_pre](const _ast_entity &ae,
+					   std::uint32_t) {
+	    return ae._process(processor_pre);
+	  };
+	  const std::vector<std::size_t> m_post =
+	    _match_kinds<const_types_post>();
+	  auto &&_c_post = [&](const _ast_entity &ae,
+			       const std::uint32_t kind) {
+	    impl::_kind_dispatcher<const_types_post>::
+	      template call<void>(m_post[kind], c_post, ae);
+	  };
+	  _walk_pre_and_po<const _ast_entity>(_c_pre, _c_post);
+
+	} else {
+	  auto &&processor_pre = make_const_processor<bool>(c_pre);
+	  auto &&_c_pre = [&processor_pre](const _ast_entity &ae,
+					   std::uint32_t) {
+	    return ae._process(processor_pre);
+	  };
+	  auto &&processor_post = make_const_processor<void>(c_post);
+	  auto &&_c_post = [&processor_post](const _ast_entity &ae,
+					     std::uint32_t) {
+	    ae._process(processor_post);
+	  };
+	  _walk_pre_and_po<const _ast_entity>(_c_pre, _c_post);
+	}
+      }
+
+      template <typename handled_types, typename callables_wrapper_type>
+      void _dfs_index::for_each_dfs_po(callables_wrapper_type &&c)
+      {
+	if (handled_types::size() < impl::double_dispatch_threshold) {
+	  const std::vector<std::size_t> m = _match_kinds<handled_types>();
+	  for (const auto i : _po) {
+	    const _entry &e = _entries[i];
+	    impl::_kind_dispatcher<handled_types>::
+	      template call<void>(m[e.kind], c, *e.ae);
+	  }
+	} else {
+	  auto &&processor = make_processor<void>(c);
+	  for (const auto i : _po)
+	    _entries[i].ae->_process(processor);
+	}
+      }
+
+      template <typename handled_types, typename callables_wrapper_type>
+      void _dfs_index::for_each_of(callables_wrapper_type &&c)
+      {
+	const std::vector<std::size_t> m = _match_kinds<handled_types>();
+	std::vector<std::uint32_t> ranks;
+
+	for (std::size_t kind = 0; kind < m.size(); ++kind) {
+	  if (m[kind] < handled_types::size()) {
+	    ranks.insert(ranks.end(),
+			 _kinds_po[kind].cbegin(), _kinds_po[kind].cend());
+	  }
+	}
+	std::sort(ranks.begin(), ranks.end());
+
+	for (const auto r : ranks) {
+	  const _entry &e = _entries[_po[r]];
+	  impl::_kind_dispatcher<handled_types>::
+	    template call<void>(m[e.kind], c, *e.ae);
+	}
+      }
+
+
       template <typename derived>
       ast_entity<derived>::ast_entity(const pp_tokens_range &tr)
 	noexcept
@@ -566,7 +850,22 @@ namespace klp
 	if (!_tu)
 	  return;
 
-	_tu->for_each_dfs_po<handled_types>
+	_get_dfs_index().for_each_dfs_po<handled_types>
+	  (std::forward<callables_wrapper_type>(c));
+      }
+
+      template <typename handled_types, typename callables_wrapper_type>
+      void ast_translation_unit::for_each_of(callables_wrapper_type &&c)
+      {
+	static_assert((handled_types::size() ==
+		       (std::remove_reference<callables_wrapper_type>::type::
+			size())),
+		      "number of overloads != number of handled types");
+
+	if (!_tu)
+	  return;
+
+	_get_dfs_index().for_each_of<handled_types>
 	  (std::forward<callables_wrapper_type>(c));
       }
 
@@ -581,8 +880,8 @@ namespace klp
 	if (!_tu)
 	  return;
 
-	_tu->for_each_dfs_pre_and_po<handled_types_pre,
-				     handled_types_post>
+	_get_dfs_index().for_each_dfs_pre_and_po<handled_types_pre,
+						 handled_types_post>
 	  (std::forward<callables_wrapper_type_pre>(c_pre),
 	   std::forward<callables_wrapper_type_post>(c_post));
       }
@@ -599,7 +898,7 @@ namespace klp
 	if (!_tu)
 	  return;
 
-	const_cast<const translation_unit&>(*_tu)
+	const_cast<const _dfs_index&>(_get_dfs_index())
 	  .for_each_dfs_pre_and_po<handled_types_pre,
 				   handled_types_post>
 	  (std::forward<callables_wrapper_type_pre>(c_pre),
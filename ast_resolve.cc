@@ -18,6 +18,7 @@
 
 #include <cassert>
 #include <string>
+#include <unordered_map>
 #include "ast_impl.hh"
 #include "semantic_except.hh"
 #include "pp_token.hh"
@@ -113,7 +114,7 @@ void ast_translation_unit::_register_labels()
 	   registrar->register_label(sl);
 	 }));
 
-  this->for_each_dfs_po<type_set<stmt_labeled> >(stmt_labeled_handler);
+  this->for_each_of<type_set<stmt_labeled> >(stmt_labeled_handler);
 }
 
 
@@ -151,6 +152,10 @@ namespace
     void _enter_scope();
     void _leave_scope();
 
+    void _add_declared_id(const expr_id::resolved &r);
+    void _add_declared_sou(const sou_decl_link &l);
+    void _add_declared_enum(const enum_decl_link &l);
+
     const expr_id::resolved* _lookup_id(const pp_token_index id_tok,
 					bool *in_cur_scope = nullptr)
       const noexcept;
@@ -203,6 +208,14 @@ namespace
       std::vector<expr_id::resolved> _declared_ids;
       std::vector<sou_decl_link> _declared_sous;
       std::vector<enum_decl_link> _declared_enums;
+
+      // Indices into the above, keyed by identifier. For ordinary
+      // identifiers, all declarations are indexed in order, for tags
+      // only the most recent one.
+      std::unordered_map<interned_string, std::vector<std::size_t>>
+	_declared_ids_index;
+      std::unordered_map<interned_string, std::size_t> _declared_sous_index;
+      std::unordered_map<interned_string, std::size_t> _declared_enums_index;
     };
 
     typedef std::vector<_scope> _scopes_type;
@@ -334,12 +347,12 @@ void _id_resolver::operator()()
 	return false;
       },
       [this](enumerator &e) {
-	_scopes.back()._declared_ids.push_back(expr_id::resolved(e));
+	_add_declared_id(expr_id::resolved(e));
 	return false;
       },
       [this](identifier_list &pil) {
 	if (_is_fundef_ddf_pil(pil))
-	  _scopes.back()._declared_ids.push_back(expr_id::resolved(pil));
+	  _add_declared_id(expr_id::resolved(pil));
 	return false;
       },
       [this](struct_or_union_ref &sour) {
@@ -413,6 +426,103 @@ void _id_resolver::_leave_scope()
   _scopes.pop_back();
 }
 
+void _id_resolver::_add_declared_id(const expr_id::resolved &r)
+{
+  _scope &scope = _scopes.back();
+  const std::size_t i = scope._declared_ids.size();
+  scope._declared_ids.push_back(r);
+
+  auto index = [&](const pp_token_index id_tok) {
+    scope._declared_ids_index[_ast.get_pp_tokens()[id_tok]
+			      .get_interned_value()].push_back(i);
+  };
+
+  switch (r.get_kind()) {
+  case resolved_kind::init_declarator:
+    index(r.get_init_declarator().get_declarator().
+	  get_direct_declarator_id().get_id_tok());
+    break;
+
+  case resolved_kind::parameter_declaration_declarator:
+    index(r.get_parameter_declaration_declarator()
+	  .get_declarator().get_direct_declarator_id().get_id_tok());
+    break;
+
+  case resolved_kind::function_definition:
+    index(r.get_function_definition().get_declarator()
+	  .get_direct_declarator_id().get_id_tok());
+    break;
+
+  case resolved_kind::enumerator:
+    index(r.get_enumerator().get_id_tok());
+    break;
+
+  case resolved_kind::in_param_id_list:
+    for (auto pi_tok : r.get_param_id_list().get_identifiers())
+      index(pi_tok);
+    break;
+
+  case resolved_kind::none:
+    /* fall through */
+  case resolved_kind::builtin_func:
+    /* fall through */
+  case resolved_kind::builtin_var:
+    /* fall through */
+  case resolved_kind::stmt_labeled:
+    // These are never elements of _declared_ids
+    assert(0);
+    __builtin_unreachable();
+  };
+}
+
+void _id_resolver::_add_declared_sou(const sou_decl_link &l)
+{
+  _scope &scope = _scopes.back();
+  pp_token_index id_tok;
+  switch (l.get_target_kind()) {
+  case sou_decl_link::target_kind::ref:
+    id_tok = l.get_target_sou_ref().get_id_tok();
+    break;
+
+  case sou_decl_link::target_kind::def:
+    id_tok = l.get_target_sou_def().get_id_tok();
+    break;
+
+  case sou_decl_link::target_kind::unlinked:
+    assert(0);
+    __builtin_unreachable();
+  }
+
+  scope._declared_sous_index[_ast.get_pp_tokens()[id_tok]
+			     .get_interned_value()] =
+    scope._declared_sous.size();
+  scope._declared_sous.push_back(l);
+}
+
+void _id_resolver::_add_declared_enum(const enum_decl_link &l)
+{
+  _scope &scope = _scopes.back();
+  pp_token_index id_tok;
+  switch (l.get_target_kind()) {
+  case enum_decl_link::target_kind::ref:
+    id_tok = l.get_target_enum_ref().get_id_tok();
+    break;
+
+  case enum_decl_link::target_kind::def:
+    id_tok = l.get_target_enum_def().get_id_tok();
+    break;
+
+  case enum_decl_link::target_kind::unlinked:
+    assert(0);
+    __builtin_unreachable();
+  }
+
+  scope._declared_enums_index[_ast.get_pp_tokens()[id_tok]
+			      .get_interned_value()] =
+    scope._declared_enums.size();
+  scope._declared_enums.push_back(l);
+}
+
 const expr_id::resolved* _id_resolver::_lookup_id(const pp_token_index id_tok,
 						  bool *in_cur_scope)
   const noexcept
@@ -427,91 +537,25 @@ const expr_id::resolved* _id_resolver::_lookup_id(const pp_token_index id_tok,
 						  bool *in_cur_scope)
   const noexcept
 {
-  const expr_id::resolved *result = nullptr;
-
   if (in_cur_scope)
     *in_cur_scope = false;
 
-  const pp_token &id = _ast.get_pp_tokens()[id_tok];
+  const interned_string &id = _ast.get_pp_tokens()[id_tok].get_interned_value();
   const auto &scopes_begin =  _scopes.rbegin();
   for (auto scope_it = scopes_begin; scope_it != _scopes.rend(); ++scope_it) {
-    for (auto r_it = scope_it->_declared_ids.rbegin();
-	 !result && r_it != scope_it->_declared_ids.rend();
-	 ++r_it) {
-      switch (r_it->get_kind()) {
-	case resolved_kind::init_declarator:
-	  {
-	    const pp_token_index r_id_tok
-	      = (r_it->get_init_declarator().get_declarator().
-		 get_direct_declarator_id().get_id_tok());
-	    if (id.get_value() ==_ast.get_pp_tokens()[r_id_tok].get_value())
-	      result = &*r_it;
-	  }
-	  break;
-
-      case resolved_kind::parameter_declaration_declarator:
-	  {
-	    const pp_token_index r_id_tok
-	      = (r_it->get_parameter_declaration_declarator()
-		 .get_declarator().get_direct_declarator_id().get_id_tok());
-	    if (id.get_value() ==_ast.get_pp_tokens()[r_id_tok].get_value())
-	      result = &*r_it;
-	  }
-	  break;
-
-      case resolved_kind::function_definition:
-	  {
-	    const pp_token_index r_id_tok
-	      = (r_it->get_function_definition().get_declarator()
-		 .get_direct_declarator_id().get_id_tok());
-	    if (id.get_value() ==_ast.get_pp_tokens()[r_id_tok].get_value())
-	      result = &*r_it;
-	  }
-	  break;
-
-      case resolved_kind::enumerator:
-	{
-	  const pp_token_index r_id_tok = r_it->get_enumerator().get_id_tok();
-	  if (id.get_value() ==_ast.get_pp_tokens()[r_id_tok].get_value())
-	    result = &*r_it;
-	}
-	break;
-
-      case resolved_kind::in_param_id_list:
-	{
-	  const identifier_list &pil = r_it->get_param_id_list();
-	  for (auto pi_tok : pil.get_identifiers()) {
-	    if (id.get_value() == _ast.get_pp_tokens()[pi_tok].get_value()) {
-	      result = &*r_it;
-	      break;
-	    }
-	  }
-	}
-	break;
-
-      case resolved_kind::none:
-	/* fall through */
-      case resolved_kind::builtin_func:
-	/* fall through */
-      case resolved_kind::builtin_var:
-	/* fall through */
-      case resolved_kind::stmt_labeled:
-	// These are never elements of _declared_ids
-	assert(0);
-	__builtin_unreachable();
-      };
-
-      if (result && !pred(*result)) {
-	result = nullptr;
-	break;
-      }
-    }
-
-    if (result) {
-      if (in_cur_scope && scope_it == scopes_begin)
-	*in_cur_scope = true;
-      return result;
-    }
+    const auto it_index = scope_it->_declared_ids_index.find(id);
+    if (it_index == scope_it->_declared_ids_index.end())
+      continue;
+
+    // Only the most recent declaration in a given scope is eligible.
+    const expr_id::resolved &result =
+      scope_it->_declared_ids[it_index->second.back()];
+    if (!pred(result))
+      continue;
+
+    if (in_cur_scope && scope_it == scopes_begin)
+      *in_cur_scope = true;
+    return &result;
   }
 
   return nullptr;
@@ -522,7 +566,8 @@ _lookup_sou_decl(const pp_token_index id_tok, const bool only_in_cur_scope,
 		 const bool skip_cur_scope)
   const noexcept
 {
-  const pp_token &_id_tok = _ast.get_pp_tokens()[id_tok];
+  const interned_string &id =
+    _ast.get_pp_tokens()[id_tok].get_interned_value();
   assert(_scopes.size() > 0);
   const auto scopes_end =
     (!only_in_cur_scope ?
@@ -533,27 +578,9 @@ _lookup_sou_decl(const pp_token_index id_tok, const bool only_in_cur_scope,
      _scopes.rbegin() :
      _scopes.rbegin() + 1);
   for (auto scope_it = scopes_begin; scope_it != scopes_end; ++scope_it) {
-    for (auto d_it = scope_it->_declared_sous.rbegin();
-	 d_it != scope_it->_declared_sous.rend(); ++d_it) {
-      pp_token_index d_id_tok;
-      switch (d_it->get_target_kind()) {
-      case sou_decl_link::target_kind::ref:
-	d_id_tok = d_it->get_target_sou_ref().get_id_tok();
-	break;
-
-      case sou_decl_link::target_kind::def:
-	d_id_tok = d_it->get_target_sou_def().get_id_tok();
-	break;
-
-      case sou_decl_link::target_kind::unlinked:
-	assert(0);
-	__builtin_unreachable();
-      }
-
-      if (_id_tok.get_value() == _ast.get_pp_tokens()[d_id_tok].get_value()) {
-	return &*d_it;
-      }
-    }
+    const auto it_index = scope_it->_declared_sous_index.find(id);
+    if (it_index != scope_it->_declared_sous_index.end())
+      return &scope_it->_declared_sous[it_index->second];
   }
 
   return nullptr;
@@ -564,7 +591,8 @@ _lookup_enum_decl(const pp_token_index id_tok, const bool only_in_cur_scope,
 		  const bool skip_cur_scope)
   const noexcept
 {
-  const pp_token &_id_tok = _ast.get_pp_tokens()[id_tok];
+  const interned_string &id =
+    _ast.get_pp_tokens()[id_tok].get_interned_value();
   assert(_scopes.size() > 0);
   const auto scopes_end =
     (!only_in_cur_scope ?
@@ -575,27 +603,9 @@ _lookup_enum_decl(const pp_token_index id_tok, const bool only_in_cur_scope,
      _scopes.rbegin() :
      _scopes.rbegin() + 1);
   for (auto scope_it = scopes_begin; scope_it != scopes_end; ++scope_it) {
-    for (auto d_it = scope_it->_declared_enums.rbegin();
-	 d_it != scope_it->_declared_enums.rend(); ++d_it) {
-      pp_token_index d_id_tok;
-      switch (d_it->get_target_kind()) {
-      case enum_decl_link::target_kind::ref:
-	d_id_tok = d_it->get_target_enum_ref().get_id_tok();
-	break;
-
-      case enum_decl_link::target_kind::def:
-	d_id_tok = d_it->get_target_enum_def().get_id_tok();
-	break;
-
-      case enum_decl_link::target_kind::unlinked:
-	assert(0);
-	__builtin_unreachable();
-      }
-
-      if (_id_tok.get_value() == _ast.get_pp_tokens()[d_id_tok].get_value()) {
-	return &*d_it;
-      }
-    }
+    const auto it_index = scope_it->_declared_enums_index.find(id);
+    if (it_index != scope_it->_declared_enums_index.end())
+      return &scope_it->_declared_enums[it_index->second];
   }
 
   return nullptr;
@@ -650,7 +660,7 @@ void _id_resolver::_handle_init_decl(init_declarator &id)
       throw semantic_except(remark);
     }
 
-    _scopes.back()._declared_ids.push_back(expr_id::resolved(id));
+    _add_declared_id(expr_id::resolved(id));
     return;
   }
 
@@ -678,7 +688,7 @@ void _id_resolver::_handle_init_decl(init_declarator &id)
       linkage::set_first_at_file_scope(id);
     }
 
-    _scopes.back()._declared_ids.push_back(expr_id::resolved(id));
+    _add_declared_id(expr_id::resolved(id));
     return;
 
   } else if (prev_is_td_in_cur_scope) {
@@ -718,7 +728,7 @@ void _id_resolver::_handle_init_decl(init_declarator &id)
   }
 
   if (no_linkage) {
-    _scopes.back()._declared_ids.push_back(expr_id::resolved(id));
+    _add_declared_id(expr_id::resolved(id));
     return;
   }
 
@@ -866,7 +876,7 @@ void _id_resolver::_handle_init_decl(init_declarator &id)
     __builtin_unreachable();
   }
 
-  _scopes.back()._declared_ids.push_back(expr_id::resolved(id));
+  _add_declared_id(expr_id::resolved(id));
 }
 
 void _id_resolver::_handle_param_decl(parameter_declaration_declarator &pdd)
@@ -883,7 +893,7 @@ void _id_resolver::_handle_param_decl(parameter_declaration_declarator &pdd)
     throw semantic_except(remark);
   }
 
-  _scopes.back()._declared_ids.push_back(expr_id::resolved(pdd));
+  _add_declared_id(expr_id::resolved(pdd));
 }
 
 void _id_resolver::_handle_fun_def(function_definition &fd)
@@ -1001,7 +1011,7 @@ void _id_resolver::_handle_fun_def(function_definition &fd)
     }
   }
 
-  _scopes.back()._declared_ids.push_back(expr_id::resolved(fd));
+  _add_declared_id(expr_id::resolved(fd));
 }
 
 void _id_resolver::_handle_sou_ref(struct_or_union_ref &sour)
@@ -1037,7 +1047,7 @@ void _id_resolver::_handle_sou_ref(struct_or_union_ref &sour)
       __builtin_unreachable();
     }
 
-    _scopes.back()._declared_sous.push_back(sou_decl_link(sour));
+    _add_declared_sou(sou_decl_link(sour));
 
   } else if (!prev_decl) {
     // It's the first occurence and thus a declaration.
@@ -1049,7 +1059,7 @@ void _id_resolver::_handle_sou_ref(struct_or_union_ref &sour)
       throw semantic_except(remark);
     }
 
-    _scopes.back()._declared_sous.push_back(sou_decl_link(sour));
+    _add_declared_sou(sou_decl_link(sour));
     return;
 
   } else {
@@ -1143,7 +1153,7 @@ void _id_resolver::_handle_sou_def(struct_or_union_def &soud)
     }
   }
 
-  _scopes.back()._declared_sous.push_back(sou_decl_link(soud));
+  _add_declared_sou(sou_decl_link(soud));
 }
 
 void _id_resolver::_handle_enum_ref(enum_ref &er)
@@ -1177,7 +1187,7 @@ void _id_resolver::_handle_enum_ref(enum_ref &er)
       __builtin_unreachable();
     }
 
-    _scopes.back()._declared_enums.push_back(enum_decl_link(er));
+    _add_declared_enum(enum_decl_link(er));
 
   } else if (!prev_decl) {
     // It's the first occurence and thus a declaration.
@@ -1189,7 +1199,7 @@ void _id_resolver::_handle_enum_ref(enum_ref &er)
       throw semantic_except(remark);
     }
 
-    _scopes.back()._declared_enums.push_back(enum_decl_link(er));
+    _add_declared_enum(enum_decl_link(er));
     return;
 
   } else {
@@ -1263,7 +1273,7 @@ void _id_resolver::_handle_enum_def(enum_def &ed)
     }
   }
 
-  _scopes.back()._declared_enums.push_back(enum_decl_link(ed));
+  _add_declared_enum(enum_decl_link(ed));
 }
 
 linkage::linkage_kind
@@ -1516,17 +1526,18 @@ void _id_resolver::_resolve_id(type_specifier_tdid &ts_tdid)
   const pp_token &id_tok = _ast.get_pp_tokens()[ts_tdid.get_id_tok()];
   for (auto scope_it = _scopes.rbegin(); scope_it != _scopes.rend();
        ++scope_it) {
-    for (auto r_it = scope_it->_declared_ids.rbegin();
-	 r_it != scope_it->_declared_ids.rend(); ++r_it) {
-      if (r_it->get_kind() == resolved_kind::init_declarator) {
-	init_declarator &id = r_it->get_init_declarator();
-	const direct_declarator_id &ddid =
-	  id.get_declarator().get_direct_declarator_id();
-	if (id_tok.get_value() ==
-	    _ast.get_pp_tokens()[ddid.get_id_tok()].get_value()) {
-	  ts_tdid.set_resolved(type_specifier_tdid::resolved{id});
-	  return;
-	}
+    const auto it_index =
+      scope_it->_declared_ids_index.find(id_tok.get_interned_value());
+    if (it_index == scope_it->_declared_ids_index.end())
+      continue;
+
+    for (auto i_it = it_index->second.rbegin();
+	 i_it != it_index->second.rend(); ++i_it) {
+      expr_id::resolved &r = scope_it->_declared_ids[*i_it];
+      if (r.get_kind() == resolved_kind::init_declarator) {
+	ts_tdid.set_resolved(type_specifier_tdid::resolved{
+				r.get_init_declarator()});
+	return;
       }
     }
   }
@@ -43,30 +43,26 @@ int main(int argc, char* argv[])
   p.add_root_source(argv[1], false);
   p.set_base_file(argv[1]);
 
-  const pp_tokens &tokens = p.get_result().get_pp_tokens();
-  while(true) {
-    try {
-      auto &tok = tokens[p.read_next_token()];
-      if (!p.get_remarks().empty()) {
-	std::cerr << p.get_remarks();
-	p.get_remarks().clear();
-      }
+  try {
+    p.stream_tokens([&p](const pp_token &tok) {
+	if (!p.get_remarks().empty()) {
+	  std::cerr << p.get_remarks();
+	  p.get_remarks().clear();
+	}
 
-      if (tok.is_eof())
-	break;
+	if (!tok.is_eof())
+	  std::cout << tok.stringify();
+      });
 
-      std::cout << tok.stringify();
-
-    } catch (const pp_except&) {
-	std::cerr << p.get_remarks();
-	return 1;
-    } catch (const parse_except&) {
-      std::cerr << p.get_remarks();
-      return 2;
-    } catch (const semantic_except&) {
-      std::cerr << p.get_remarks();
-      return 3;
-    }
+  } catch (const pp_except&) {
+    std::cerr << p.get_remarks();
+    return 1;
+  } catch (const parse_except&) {
+    std::cerr << p.get_remarks();
+    return 2;
+  } catch (const semantic_except&) {
+    std::cerr << p.get_remarks();
+    return 3;
   }
 
   return 0;
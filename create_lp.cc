@@ -4590,7 +4590,12 @@ void _closure_builder::operator()()
 {
   // Externalization can depend on whether or not some function
   // definition is contained within some header eligible for
-  // inclusion. Query the policy for eligibility now.
+  // inclusion. Query the policy for eligibility now.  Marking a
+  // header uneligible affects only its parents, which have been
+  // visited before, so the non-root headers can all be queried in
+  // one batch.
+  std::vector<header_info *> children;
+  std::vector<const pp_result::header_inclusion_child *> child_nodes;
   for (auto &h : _ai.header_infos) {
     if (!h.eligible)
       continue;
@@ -4605,11 +4610,18 @@ void _closure_builder::operator()()
       }
 
     } else {
-      if (!_pol.is_header_eligible(h.get_child_node(), _remarks))
-	_ai.mark_header_uneligible(h);
+      children.push_back(&h);
+      child_nodes.push_back(&h.get_child_node());
     }
   }
 
+  const std::vector<bool> eligible =
+    _pol.are_headers_eligible(child_nodes, _remarks);
+  for (std::size_t i = 0; i < children.size(); ++i) {
+    if (!eligible[i])
+      _ai.mark_header_uneligible(*children[i]);
+  }
+
   _construct_fd_id_closure();
 }
 
@@ -4742,9 +4754,34 @@ void _closure_builder::_construct_fd_id_closure()
   // patched set is contained in, initialize externalizability etc.
   std::size_t n_pending_nodes_w_incoming_er_edges = 0;
   {
+    // Before descending into some function definition or object
+    // initializer, let the policy speculatively answer the
+    // externalizability queries for all of its callees at once.
+    std::vector<const ast::function_definition *> prefetch_fds;
+    auto &&add_prefetch_fds
+      = [&](const deps_on_funs &deps) {
+	  for (const auto &d : deps) {
+	    const function_info &fi = d.get_function_info();
+	    const function_definition_info * const fdi =
+	      fi.get_function_definition();
+	    if (fdi && !fi.can_externalize_valid)
+	      prefetch_fds.push_back(&fdi->function_definition);
+	  }
+	};
+    auto &&prefetch
+      = [&]() {
+	  if (!prefetch_fds.empty()) {
+	    _pol.prefetch_function_externalizability(prefetch_fds);
+	    prefetch_fds.clear();
+	  }
+	};
+
     const unsigned int cur_walk_gen_nr = _ai.start_walk();
-    for (auto fdi : patched_set)
+    for (auto fdi : patched_set) {
       fdi->init_walk_data(cur_walk_gen_nr);
+      add_prefetch_fds(fdi->body_deps.on_funs);
+    }
+    prefetch();
 
     auto &&dep_on_fun_visitor
       = [&](dep_on_fun &d) {
@@ -4797,6 +4834,10 @@ void _closure_builder::_construct_fd_id_closure()
 	      }
 	      return false;
 	    } else {
+	      if (fdi->walk_gen_nr != cur_walk_gen_nr) {
+		add_prefetch_fds(fdi->body_deps.on_funs);
+		prefetch();
+	      }
 	      return true;
 	    }
 
@@ -4863,8 +4904,15 @@ void _closure_builder::_construct_fd_id_closure()
 
 	  assert(!d.externalize);
 	  d.externalize = oi.shall_externalize;
-	  if (!d.externalize && oi.get_initializing_init_declarator())
+	  object_init_declarator_info * const oidi =
+	    oi.get_initializing_init_declarator();
+	  if (!d.externalize && oidi) {
+	    if (oidi->walk_gen_nr != cur_walk_gen_nr) {
+	      add_prefetch_fds(oidi->get_initializer()->deps.on_funs);
+	      prefetch();
+	    }
 	    return true;
+	  }
 	  return false;
 	};
 
@@ -9377,11 +9425,23 @@ void klp::ccp::create_lp(const std::string &outfile,
   // Populate the ast_info and collect all interdependencies.
   _ast_info_collector{ai, remarks}();
 
-  for (auto it_fi = ai.functions_begin(); it_fi != ai.functions_end();
-       ++it_fi) {
-    function_definition_info * const fdi = it_fi->get_function_definition();
-    if (fdi && pol.is_patched(fdi->function_definition, remarks))
-      fdi->is_patched = true;
+  {
+    std::vector<function_definition_info *> fdis;
+    std::vector<const ast::function_definition *> fds;
+    for (auto it_fi = ai.functions_begin(); it_fi != ai.functions_end();
+	 ++it_fi) {
+      function_definition_info * const fdi = it_fi->get_function_definition();
+      if (fdi) {
+	fdis.push_back(fdi);
+	fds.push_back(&fdi->function_definition);
+      }
+    }
+
+    const std::vector<bool> patched = pol.are_patched(fds, remarks);
+    for (std::size_t i = 0; i < fdis.size(); ++i) {
+      if (patched[i])
+	fdis[i]->is_patched = true;
+    }
   }
 
   // Find all objects and functions reachable from the patched
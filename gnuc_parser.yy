@@ -1939,7 +1939,7 @@ iteration_statement:
 	     * a typedef identifier.
 	     */
 	    if (yyla.type == by_type(token::TOK_IDENTIFIER).type) {
-	      if (pd.is_typedef_id(pd._pp.get_result().get_pp_tokens()[yyla.value.token_index].get_value())) {
+	      if (pd.is_typedef_id(pd._pp.get_result().get_pp_tokens()[yyla.value.token_index].get_interned_value())) {
 		yyla.type = by_type(token::TOK_TYPEDEF_IDENTIFIER).type;
 	      }
 	    }
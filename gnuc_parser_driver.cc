@@ -163,11 +163,12 @@ static _val_tok_map_type _initialize_val_tok_map(const _val_tok_map_entry *e)
 gnuc_parser_driver::gnuc_parser_driver(preprocessor &&pp,
 				       const architecture &arch)
   : _result(nullptr), _pp(std::move(pp)),
-    _parser(*this), _ignore_td_spec(0), _in_typedef(false)
+    _parser(*this), _arena(new arena()), _ignore_td_spec(0),
+    _in_typedef(false)
 {
-  _typedefs_scopes.emplace();
+  _typedefs_scopes.emplace_back();
   for (const auto &btd : arch.get_builtin_typedefs())
-    _typedefs_scopes.top().insert(btd.name);
+    _set_typedef_id(btd.name, true);
 }
 
 gnuc_parser_driver::~gnuc_parser_driver() noexcept
@@ -177,6 +178,7 @@ gnuc_parser_driver::~gnuc_parser_driver() noexcept
 
 void gnuc_parser_driver::parse()
 {
+  arena::activation aa(_arena.get());
   _parser.parse();
 }
 
@@ -194,6 +196,7 @@ ast_translation_unit gnuc_parser_driver::grab_result()
   _result = nullptr;
 
   if (!tu) {
+    arena::activation aa(_arena.get());
     tu.reset(new translation_unit{
 			pp_tokens_range{
 			  _pp.get_result().get_pp_tokens().size(),
@@ -201,7 +204,8 @@ ast_translation_unit gnuc_parser_driver::grab_result()
 			}
 		 });
   }
-  return ast_translation_unit(_pp.grab_result(), std::move(tu));
+  return ast_translation_unit(_pp.grab_result(), std::move(_arena),
+			      std::move(tu));
 }
 
 gnuc_parser::token_type
@@ -274,7 +278,7 @@ gnuc_parser_driver::lex(gnuc_parser::semantic_type *value,
 
     value->token_index = loc->begin;
 
-    if (is_typedef_id(tok.get_value())) {
+    if (is_typedef_id(tok.get_interned_value())) {
       return gnuc_parser::token_type::TOK_TYPEDEF_IDENTIFIER;
     }
     return gnuc_parser::token_type::TOK_IDENTIFIER;
@@ -359,25 +363,35 @@ void gnuc_parser_driver::error(const gnuc_parser::location_type& loc,
 void gnuc_parser_driver::enter_td_scope()
 {
   assert(!_typedefs_scopes.empty());
-  _typedefs_scopes.push(_typedefs_scopes.top());
+  _typedefs_scopes.emplace_back();
 }
 
 void gnuc_parser_driver::leave_td_scope()
 {
-  _typedefs_scopes.pop();
+  assert(!_typedefs_scopes.empty());
+  for (const auto &id : _typedefs_scopes.back())
+    _typedef_bindings[id].pop_back();
+  _typedefs_scopes.pop_back();
 }
 
 void gnuc_parser_driver::stash_td_scope()
 {
   assert(_typedefs_scopes.size() > 1);
-  _stashed_typedef_scope = std::move(_typedefs_scopes.top());
-  _typedefs_scopes.pop();
+  _stashed_typedef_scope.clear();
+  for (const auto &id : _typedefs_scopes.back()) {
+    _stashed_typedef_scope.emplace_back
+      (id, _typedef_bindings[id].back().is_typedef);
+  }
+  leave_td_scope();
 }
 
 void gnuc_parser_driver::restore_stashed_td_scope()
 {
   assert(!_typedefs_scopes.empty());
-  _typedefs_scopes.push(std::move(_stashed_typedef_scope));
+  enter_td_scope();
+  for (const auto &b : _stashed_typedef_scope)
+    _set_typedef_id(b.first, b.second);
+  _stashed_typedef_scope.clear();
 }
 
 void gnuc_parser_driver::set_in_typedef() noexcept
@@ -412,10 +426,7 @@ void gnuc_parser_driver::handle_decl_id(const pp_token_index tok_index)
   assert(tok.is_id());
   assert(!_ignore_td_spec);
 
-  if(_in_typedef)
-    _typedefs_scopes.top().insert(tok.get_value());
-  else
-    _typedefs_scopes.top().erase(tok.get_value());
+  _set_typedef_id(tok.get_interned_value(), _in_typedef);
 }
 
 void gnuc_parser_driver::handle_enumerator_id(const pp_token_index tok_index)
@@ -424,7 +435,7 @@ void gnuc_parser_driver::handle_enumerator_id(const pp_token_index tok_index)
   assert(!_typedefs_scopes.empty());
   assert(tok.is_id());
 
-  _typedefs_scopes.top().erase(tok.get_value());
+  _set_typedef_id(tok.get_interned_value(), false);
 }
 
 void gnuc_parser_driver::handle_param_id(const pp_token_index tok_index)
@@ -433,14 +444,36 @@ void gnuc_parser_driver::handle_param_id(const pp_token_index tok_index)
   assert(!_typedefs_scopes.empty());
   assert(tok.is_id());
   assert(_ignore_td_spec);
-  _typedefs_scopes.top().erase(tok.get_value());
+  _set_typedef_id(tok.get_interned_value(), false);
 }
 
 
-bool gnuc_parser_driver::is_typedef_id(const std::string &id) const noexcept
+bool gnuc_parser_driver::is_typedef_id(const interned_string &id)
+  const noexcept
+{
+  const auto it = _typedef_bindings.find(id);
+  return (it != _typedef_bindings.end() && !it->second.empty() &&
+	  it->second.back().is_typedef);
+}
+
+void gnuc_parser_driver::_set_typedef_id(const interned_string &id,
+					 const bool is_typedef)
 {
   assert(!_typedefs_scopes.empty());
-  return _typedefs_scopes.top().count(id);
+  const std::size_t scope = _typedefs_scopes.size() - 1;
+  std::vector<_typedef_binding> &bindings = _typedef_bindings[id];
+  if (!bindings.empty() && bindings.back().scope == scope) {
+    bindings.back().is_typedef = is_typedef;
+    return;
+  }
+
+  // Nothing to record if the binding inherited from the enclosing
+  // scopes is the same.
+  if ((!bindings.empty() && bindings.back().is_typedef) == is_typedef)
+    return;
+
+  bindings.push_back(_typedef_binding{scope, is_typedef});
+  _typedefs_scopes.back().push_back(id);
 }
 
 void gnuc_parser_driver::_grab_pp_remarks()
@@ -19,14 +19,15 @@
 #ifndef GNUC_PARSER_DRIVER_HH
 #define GNUC_PARSER_DRIVER_HH
 
-#include <stack>
 #include <string>
-#include <set>
+#include <vector>
+#include <unordered_map>
 
 #include "gnuc_parser.hh"
 #include "pp_tokens.hh"
 #include "preprocessor.hh"
 #include "code_remarks.hh"
+#include "arena.hh"
 
 namespace klp
 {
@@ -81,19 +82,40 @@ namespace klp
 	void handle_enumerator_id(const pp_token_index tok_index);
 	void handle_param_id(const pp_token_index tok_index);
 
-	bool is_typedef_id(const std::string &id) const noexcept;
+	bool is_typedef_id(const interned_string &id) const noexcept;
 
 	void _grab_pp_remarks();
 
-	typedef std::set<std::string> _typedefs_type;
-	typedef std::stack<_typedefs_type> _typedefs_scopes_type;
-
+	void _set_typedef_id(const interned_string &id, const bool is_typedef);
+
+	// Whether or not an identifier denotes a typedef name at the
+	// current scope is tracked by a stack of bindings per identifier,
+	// each tagged with the scope it has been made in. Each scope
+	// records the identifiers bound in it, so that these can be
+	// popped again upon leaving it.
+	struct _typedef_binding
+	{
+	  std::size_t scope;
+	  bool is_typedef;
+	};
+
+	typedef std::unordered_map<interned_string,
+				   std::vector<_typedef_binding>>
+		_typedef_bindings_type;
+	typedef std::vector<std::vector<interned_string>> _typedefs_scopes_type;
+	typedef std::vector<std::pair<interned_string, bool>>
+		_stashed_typedef_scope_type;
+
+	_typedef_bindings_type _typedef_bindings;
 	_typedefs_scopes_type _typedefs_scopes;
-	_typedefs_type _stashed_typedef_scope;
+	_stashed_typedef_scope_type _stashed_typedef_scope;
 
 	preprocessor _pp;
 	gnuc_parser _parser;
 
+	// The AST nodes get allocated from _arena during parse(), whose
+	// ownership is passed on to the ast_translation_unit eventually.
+	std::unique_ptr<arena> _arena;
 	ast::translation_unit *_result;
 
 	code_remarks _remarks;
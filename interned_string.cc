@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <unordered_set>
+#include "interned_string.hh"
+
+using namespace klp::ccp;
+
+interned_string::interned_string()
+{
+  static const std::string * const empty = _intern(std::string());
+  _s = empty;
+}
+
+interned_string::interned_string(const std::string &s)
+  : _s(_intern(s))
+{}
+
+interned_string::interned_string(const char * const s)
+  : _s(_intern(s))
+{}
+
+const std::string* interned_string::_intern(const std::string &s)
+{
+  // Elements of an unordered_set never move, even upon rehashing.
+  static std::unordered_set<std::string> table;
+
+  return &*table.insert(s).first;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef INTERNED_STRING_HH
+#define INTERNED_STRING_HH
+
+#include <string>
+#include <functional>
+
+namespace klp
+{
+  namespace ccp
+  {
+    // A handle to a string stored once in a process-wide table. Copies
+    // are cheap and comparisons for equality don't need to look at the
+    // string's contents. Note that the ordering defined by operator<
+    // is not the lexicographical one.
+    class interned_string
+    {
+    public:
+      interned_string();
+
+      interned_string(const std::string &s);
+
+      interned_string(const char * const s);
+
+      const std::string& str() const noexcept
+      { return *_s; }
+
+      operator const std::string&() const noexcept
+      { return *_s; }
+
+      bool operator==(const interned_string &rhs) const noexcept
+      { return _s == rhs._s; }
+
+      bool operator!=(const interned_string &rhs) const noexcept
+      { return _s != rhs._s; }
+
+      bool operator<(const interned_string &rhs) const noexcept
+      { return std::less<const std::string *>()(_s, rhs._s); }
+
+      std::size_t hash() const noexcept
+      { return std::hash<const std::string *>()(_s); }
+
+    private:
+      static const std::string* _intern(const std::string &s);
+
+      const std::string *_s;
+    };
+  }
+}
+
+namespace std
+{
+  template<>
+  struct hash<klp::ccp::interned_string>
+  {
+    std::size_t operator()(const klp::ccp::interned_string &s) const noexcept
+    { return s.hash(); }
+  };
+}
+
+#endif
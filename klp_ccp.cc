@@ -19,11 +19,15 @@
 #include <unistd.h>
 #include <getopt.h>
 #include <cstring>
+#include <cstdlib>
+#include <limits>
 #include <iostream>
 #include <vector>
 #include "arch_x86_64_gcc.hh"
 #include "cmdline_except.hh"
 #include "user_policy_command.hh"
+#include "policy_answer_cache.hh"
+#include "policy_plugin.hh"
 #include "header_resolver.hh"
 #include "preprocessor.hh"
 #include "gnuc_parser_driver.hh"
@@ -32,6 +36,7 @@
 #include "semantic_except.hh"
 #include "lp_except.hh"
 #include "lp_creation_policy_user_commands.hh"
+#include "lp_creation_policy_plugin.hh"
 #include "output_remarks.hh"
 #include "create_lp.hh"
 
@@ -39,7 +44,7 @@ using namespace klp::ccp;
 
 static const char prog_name[] = "klp-ccp";
 
-static const char optstr[] = ":hc:o:i:I:H:F:S:O:E:P:R:";
+static const char optstr[] = ":hc:o:i:I:H:F:S:O:E:P:R:pj:C:e:L:";
 
 static const option longopts[] {
 	{ "help", 0, nullptr, 'h' },
@@ -54,6 +59,11 @@ static const option longopts[] {
 	{ "pol-cmd-modify-externalized-sym", 1, nullptr, 'E' },
 	{ "pol-cmd-modify-patched-fun-sym", 1, nullptr, 'P' },
 	{ "pol-cmd-rename-rewritten-fun", 1, nullptr, 'R' },
+	{ "pol-cmds-persistent", 0, nullptr, 'p' },
+	{ "pol-cmds-jobs", 1, nullptr, 'j' },
+	{ "pol-cache", 1, nullptr, 'C' },
+	{ "pol-cache-epoch", 1, nullptr, 'e' },
+	{ "pol-plugin", 1, nullptr, 'L' },
 	{ nullptr, 0, nullptr, 0 }
 };
 
@@ -126,7 +136,34 @@ static void show_help(const char * const prog)
     << " -R, --pol-cmd-renamed-rewritten-fun=CMD"
     << "\tPolicy command determining" << std::endl
     << "\t\t\t\t\t\trenames to apply to rewritten," << std::endl
-    << "\t\t\t\t\t\tbut non-patched functions." << std::endl
+    << "\t\t\t\t\t\tbut non-patched functions."
+    << std::endl;
+  std::cout
+    << " -p, --pol-cmds-persistent"
+    << "\t\t\tStart each policy command only once" << std::endl
+    << "\t\t\t\t\t\tand send it queries on stdin."
+    << std::endl;
+  std::cout
+    << " -j, --pol-cmds-jobs=N"
+    << "\t\t\t\tRun up to N policy commands" << std::endl
+    << "\t\t\t\t\t\tconcurrently, defaults to the" << std::endl
+    << "\t\t\t\t\t\tnumber of online CPUs."
+    << std::endl;
+  std::cout
+    << " -C, --pol-cache=FILE"
+    << "\t\t\t\tCache policy command answers" << std::endl
+    << "\t\t\t\t\t\tin FILE."
+    << std::endl;
+  std::cout
+    << " -e, --pol-cache-epoch=EPOCH"
+    << "\t\t\tDisregard answers cached under" << std::endl
+    << "\t\t\t\t\t\ta different EPOCH."
+    << std::endl;
+  std::cout
+    << " -L, --pol-plugin=FILE"
+    << "\t\t\t\tLoad policy decisions from shared" << std::endl
+    << "\t\t\t\t\t\tobject FILE instead of running" << std::endl
+    << "\t\t\t\t\t\tpolicy commands." << std::endl
     << std::endl;
 
   std::cout
@@ -190,6 +227,31 @@ static void split_patched_funs(const char *arg, std::vector<std::string> &funs)
   }
 }
 
+static std::unique_ptr<user_policy_command>
+make_pol_cmd(const char * const cmd, const char * const o,
+	     const bool persistent, const unsigned int max_jobs,
+	     policy_answer_cache * const cache)
+{
+  if (!cmd) {
+    std::cerr << "command line error: " << o << " is required" << std::endl;
+    show_usage(prog_name);
+    return nullptr;
+  }
+
+  try {
+    return std::unique_ptr<user_policy_command>{
+		new user_policy_command{cmd, persistent, max_jobs, cache}
+	   };
+
+  } catch (const user_policy_command::cmd_parse_except &e) {
+    std::cerr << "command line error: failed to parse policy command '"
+	      << cmd << "': "
+	      << e.what() << std::endl;
+    show_usage(prog_name);
+    return nullptr;
+  }
+}
+
 int main(int argc, char *argv[], char *envp[])
 {
 
@@ -205,6 +267,11 @@ int main(int argc, char *argv[], char *envp[])
   const char *o_pol_cmd_mod_externalized_sym = nullptr;
   const char *o_pol_cmd_mod_patched_fun_sym = nullptr;
   const char *o_pol_cmd_rename_rewritten_fun = nullptr;
+  bool o_pol_cmds_persistent = false;
+  const char *o_pol_cmds_jobs = nullptr;
+  const char *o_pol_cache = nullptr;
+  const char *o_pol_cache_epoch = nullptr;
+  const char *o_pol_plugin = nullptr;
 
   int o;
   int longindex = -1;
@@ -299,6 +366,42 @@ int main(int argc, char *argv[], char *envp[])
       o_pol_cmd_rename_rewritten_fun = optarg;
       break;
 
+    case 'p':
+      o_pol_cmds_persistent = true;
+      break;
+
+    case 'j':
+      if (o_pol_cmds_jobs) {
+	show_opt_duplicate(prog_name, "--pol-cmds-jobs");
+	return 1;
+      }
+      o_pol_cmds_jobs = optarg;
+      break;
+
+    case 'C':
+      if (o_pol_cache) {
+	show_opt_duplicate(prog_name, "--pol-cache");
+	return 1;
+      }
+      o_pol_cache = optarg;
+      break;
+
+    case 'e':
+      if (o_pol_cache_epoch) {
+	show_opt_duplicate(prog_name, "--pol-cache-epoch");
+	return 1;
+      }
+      o_pol_cache_epoch = optarg;
+      break;
+
+    case 'L':
+      if (o_pol_plugin) {
+	show_opt_duplicate(prog_name, "--pol-plugin");
+	return 1;
+      }
+      o_pol_plugin = optarg;
+      break;
+
     case '?':
       std::cerr << "command line error: invalid option '";
       if (optopt)
@@ -357,7 +460,7 @@ int main(int argc, char *argv[], char *envp[])
     return 1;
   }
 
-  if (!o_pol_cmd_is_patched && patched_funs.empty()) {
+  if (!o_pol_plugin && !o_pol_cmd_is_patched && patched_funs.empty()) {
     std::cerr
       << "command line error: "
       << "either --patched-functions or --pol-cmd-is-patched is required"
@@ -367,158 +470,141 @@ int main(int argc, char *argv[], char *envp[])
   }
 
 
-  std::unique_ptr<const user_policy_command> pol_cmd_is_patched;
-  if (o_pol_cmd_is_patched) {
-    try {
-      pol_cmd_is_patched.reset(new user_policy_command{o_pol_cmd_is_patched});
-
-    } catch (const user_policy_command::cmd_parse_except &e) {
-      std::cerr << "command line error: failed to parse policy command '"
-		<< o_pol_cmd_is_patched << "': "
-		<< e.what() << std::endl;
+  unsigned int pol_cmds_jobs;
+  if (o_pol_cmds_jobs) {
+    char *end;
+    const unsigned long n = std::strtoul(o_pol_cmds_jobs, &end, 10);
+    if (!*o_pol_cmds_jobs || *end || !n ||
+	n > std::numeric_limits<unsigned int>::max()) {
+      std::cerr << "command line error: invalid job count '"
+		<< o_pol_cmds_jobs << '\'' << std::endl;
       show_usage(prog_name);
       return 1;
     }
+    pol_cmds_jobs = n;
+  } else {
+    const long n = sysconf(_SC_NPROCESSORS_ONLN);
+    pol_cmds_jobs = n > 0 ? n : 1;
   }
 
-  if (!o_pol_cmd_may_include_header) {
+  std::unique_ptr<policy_answer_cache> pol_cache;
+  if (o_pol_cache) {
+    try {
+      pol_cache.reset(new policy_answer_cache{
+			o_pol_cache,
+			o_pol_cache_epoch ? o_pol_cache_epoch : ""
+		      });
+    } catch (const std::system_error &e) {
+      std::cerr << "error: failed to open policy cache: " << e.what()
+		<< std::endl;
+      return 1;
+    }
+  } else if (o_pol_cache_epoch) {
     std::cerr
-      << "command line error: --pol-cmd-may-include-header is required"
+      << "command line error: --pol-cache-epoch requires --pol-cache"
       << std::endl;
     show_usage(prog_name);
     return 1;
   }
-  std::unique_ptr<user_policy_command> pol_cmd_may_include_header;
-  try {
-    pol_cmd_may_include_header.reset
-      (new user_policy_command{o_pol_cmd_may_include_header});
-
-  } catch (const user_policy_command::cmd_parse_except &e) {
-    std::cerr << "command line error: failed to parse policy command '"
-	      << o_pol_cmd_may_include_header << "': "
-	      << e.what() << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
 
-  if (!o_pol_cmd_can_externalize_fun) {
-    std::cerr
-      << "command line error: --pol-cmd-can-externalize-fun is required"
-      << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
+  std::unique_ptr<policy_plugin> pol_plugin;
+  std::unique_ptr<const user_policy_command> pol_cmd_is_patched;
+  std::unique_ptr<user_policy_command> pol_cmd_may_include_header;
   std::unique_ptr<user_policy_command> pol_cmd_can_externalize_fun;
-  try {
-    pol_cmd_can_externalize_fun.reset
-      (new user_policy_command{o_pol_cmd_can_externalize_fun});
-
-  } catch (const user_policy_command::cmd_parse_except &e) {
-    std::cerr << "command line error: failed to parse policy command '"
-	      << o_pol_cmd_can_externalize_fun << "': "
-	      << e.what() << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
-
-  if (!o_pol_cmd_shall_externalize_fun) {
-    std::cerr
-      << "command line error: --pol-cmd-shall-externalize-fun is required"
-      << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
   std::unique_ptr<user_policy_command> pol_cmd_shall_externalize_fun;
-  try {
-    pol_cmd_shall_externalize_fun.reset
-      (new user_policy_command{o_pol_cmd_shall_externalize_fun});
+  std::unique_ptr<user_policy_command> pol_cmd_shall_externalize_obj;
+  std::unique_ptr<user_policy_command> pol_cmd_mod_externalized_sym;
+  std::unique_ptr<user_policy_command> pol_cmd_mod_patched_fun_sym;
+  std::unique_ptr<user_policy_command> pol_cmd_rename_rewritten_fun;
+  if (o_pol_plugin) {
+    if (o_pol_cmd_is_patched || o_pol_cmd_may_include_header ||
+	o_pol_cmd_can_externalize_fun || o_pol_cmd_shall_externalize_fun ||
+	o_pol_cmd_shall_externalize_obj || o_pol_cmd_mod_externalized_sym ||
+	o_pol_cmd_mod_patched_fun_sym || o_pol_cmd_rename_rewritten_fun) {
+      std::cerr
+	<< "command line error: "
+	<< "--pol-plugin can't be combined with policy commands"
+	<< std::endl;
+      show_usage(prog_name);
+      return 1;
+    }
 
-  } catch (const user_policy_command::cmd_parse_except &e) {
-    std::cerr << "command line error: failed to parse policy command '"
-	      << o_pol_cmd_shall_externalize_fun << "': "
-	      << e.what() << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
+    try {
+      pol_plugin.reset(new policy_plugin{o_pol_plugin});
+    } catch (const policy_plugin::load_except &e) {
+      std::cerr << "error: failed to load policy plugin: " << e.what()
+		<< std::endl;
+      return 1;
+    }
 
-  if (!o_pol_cmd_shall_externalize_obj) {
-    std::cerr
-      << "command line error: --pol-cmd-shall-externalize-obj is required"
-      << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
-  std::unique_ptr<user_policy_command> pol_cmd_shall_externalize_obj;
-  try {
-    pol_cmd_shall_externalize_obj.reset
-      (new user_policy_command{o_pol_cmd_shall_externalize_obj});
+    if (!pol_plugin->get_ops().is_patched && patched_funs.empty()) {
+      std::cerr
+	<< "command line error: "
+	<< "--patched-functions is required, policy plugin doesn't implement"
+	<< " is_patched"
+	<< std::endl;
+      show_usage(prog_name);
+      return 1;
+    }
 
-  } catch (const user_policy_command::cmd_parse_except &e) {
-    std::cerr << "command line error: failed to parse policy command '"
-	      << o_pol_cmd_shall_externalize_obj << "': "
-	      << e.what() << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
+  } else {
+    if (o_pol_cmd_is_patched) {
+      pol_cmd_is_patched = make_pol_cmd(o_pol_cmd_is_patched,
+					"--pol-cmd-is-patched",
+					o_pol_cmds_persistent, pol_cmds_jobs,
+					pol_cache.get());
+      if (!pol_cmd_is_patched)
+	return 1;
+    }
 
-  if (!o_pol_cmd_mod_externalized_sym) {
-    std::cerr
-      << "command line error: --pol-cmd-modify-externalized-sym is required"
-      << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
-  std::unique_ptr<user_policy_command> pol_cmd_mod_externalized_sym;
-  try {
-    pol_cmd_mod_externalized_sym.reset
-      (new user_policy_command{o_pol_cmd_mod_externalized_sym});
+    pol_cmd_may_include_header =
+      make_pol_cmd(o_pol_cmd_may_include_header,
+		   "--pol-cmd-may-include-header",
+		   o_pol_cmds_persistent, pol_cmds_jobs, pol_cache.get());
+    if (!pol_cmd_may_include_header)
+      return 1;
 
-  } catch (const user_policy_command::cmd_parse_except &e) {
-    std::cerr << "command line error: failed to parse policy command '"
-	      << o_pol_cmd_mod_externalized_sym << "': "
-	      << e.what() << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
+    pol_cmd_can_externalize_fun =
+      make_pol_cmd(o_pol_cmd_can_externalize_fun,
+		   "--pol-cmd-can-externalize-fun",
+		   o_pol_cmds_persistent, pol_cmds_jobs, pol_cache.get());
+    if (!pol_cmd_can_externalize_fun)
+      return 1;
 
-  if (!o_pol_cmd_mod_patched_fun_sym) {
-    std::cerr
-      << "command line error: --pol-cmd-modify-patched-fun-sym is required"
-      << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
-  std::unique_ptr<user_policy_command> pol_cmd_mod_patched_fun_sym;
-  try {
-    pol_cmd_mod_patched_fun_sym.reset
-      (new user_policy_command{o_pol_cmd_mod_patched_fun_sym});
+    pol_cmd_shall_externalize_fun =
+      make_pol_cmd(o_pol_cmd_shall_externalize_fun,
+		   "--pol-cmd-shall-externalize-fun",
+		   o_pol_cmds_persistent, pol_cmds_jobs, pol_cache.get());
+    if (!pol_cmd_shall_externalize_fun)
+      return 1;
 
-  } catch (const user_policy_command::cmd_parse_except &e) {
-    std::cerr << "command line error: failed to parse policy command '"
-	      << o_pol_cmd_mod_patched_fun_sym << "': "
-	      << e.what() << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
+    pol_cmd_shall_externalize_obj =
+      make_pol_cmd(o_pol_cmd_shall_externalize_obj,
+		   "--pol-cmd-shall-externalize-obj",
+		   o_pol_cmds_persistent, pol_cmds_jobs, pol_cache.get());
+    if (!pol_cmd_shall_externalize_obj)
+      return 1;
 
-  if (!o_pol_cmd_rename_rewritten_fun) {
-    std::cerr
-      << "command line error: --pol-cmd-rename-rewritten-fun is required"
-      << std::endl;
-    show_usage(prog_name);
-    return 1;
-  }
-  std::unique_ptr<user_policy_command> pol_cmd_rename_rewritten_fun;
-  try {
-    pol_cmd_rename_rewritten_fun.reset
-      (new user_policy_command{o_pol_cmd_rename_rewritten_fun});
+    pol_cmd_mod_externalized_sym =
+      make_pol_cmd(o_pol_cmd_mod_externalized_sym,
+		   "--pol-cmd-modify-externalized-sym",
+		   o_pol_cmds_persistent, pol_cmds_jobs, pol_cache.get());
+    if (!pol_cmd_mod_externalized_sym)
+      return 1;
 
-  } catch (const user_policy_command::cmd_parse_except &e) {
-    std::cerr << "command line error: failed to parse policy command '"
-	      << o_pol_cmd_rename_rewritten_fun << "': "
-	      << e.what() << std::endl;
-    show_usage(prog_name);
-    return 1;
+    pol_cmd_mod_patched_fun_sym =
+      make_pol_cmd(o_pol_cmd_mod_patched_fun_sym,
+		   "--pol-cmd-modify-patched-fun-sym",
+		   o_pol_cmds_persistent, pol_cmds_jobs, pol_cache.get());
+    if (!pol_cmd_mod_patched_fun_sym)
+      return 1;
+
+    pol_cmd_rename_rewritten_fun =
+      make_pol_cmd(o_pol_cmd_rename_rewritten_fun,
+		   "--pol-cmd-rename-rewritten-fun",
+		   o_pol_cmds_persistent, pol_cmds_jobs, pol_cache.get());
+    if (!pol_cmd_rename_rewritten_fun)
+      return 1;
   }
 
 
@@ -600,24 +686,33 @@ int main(int argc, char *argv[], char *envp[])
     return r;
 
 
-  lp_creation_policy_user_commands pol{
-	ast.get_pp_result(),
-	envp,
-	std::move(patched_funs),
-	std::move(pol_cmd_is_patched),
-	std::move(*pol_cmd_may_include_header),
-	std::move(*pol_cmd_can_externalize_fun),
-	std::move(*pol_cmd_shall_externalize_fun),
-	std::move(*pol_cmd_shall_externalize_obj),
-	std::move(*pol_cmd_mod_externalized_sym),
-	std::move(*pol_cmd_mod_patched_fun_sym),
-	std::move(*pol_cmd_rename_rewritten_fun),
-  };
+  std::unique_ptr<lp_creation_policy> pol;
+  if (pol_plugin) {
+    pol.reset(new lp_creation_policy_plugin{
+		ast.get_pp_result(),
+		std::move(patched_funs),
+		*pol_plugin,
+	      });
+  } else {
+    pol.reset(new lp_creation_policy_user_commands{
+		ast.get_pp_result(),
+		envp,
+		std::move(patched_funs),
+		std::move(pol_cmd_is_patched),
+		std::move(*pol_cmd_may_include_header),
+		std::move(*pol_cmd_can_externalize_fun),
+		std::move(*pol_cmd_shall_externalize_fun),
+		std::move(*pol_cmd_shall_externalize_obj),
+		std::move(*pol_cmd_mod_externalized_sym),
+		std::move(*pol_cmd_mod_patched_fun_sym),
+		std::move(*pol_cmd_rename_rewritten_fun),
+	      });
+  }
 
   code_remarks iremarks;
   output_remarks oremarks;
   try {
-    create_lp(o_outfile, ast, pol, iremarks, oremarks);
+    create_lp(o_outfile, ast, *pol, iremarks, oremarks);
 
   } catch (const lp_except&) {
     r = 3;
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * C ABI for in-process policy plugins loaded with --pol-plugin.
+ *
+ * A plugin is a shared object exporting a
+ *   const struct klp_ccp_pol_plugin_ops klp_ccp_pol_plugin_ops;
+ * with .abi_version set to KLP_CCP_POL_PLUGIN_ABI_VERSION. The
+ * operations make the same decisions as the corresponding policy
+ * commands, c.f. README.md.
+ */
+
+#ifndef KLP_CCP_POLICY_PLUGIN_H
+#define KLP_CCP_POLICY_PLUGIN_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KLP_CCP_POL_PLUGIN_ABI_VERSION 1
+#define KLP_CCP_POL_PLUGIN_OPS_SYMBOL "klp_ccp_pol_plugin_ops"
+
+/*
+ * A string which is not necessarily NUL terminated. Strings passed to
+ * a plugin are valid only for the duration of the call.
+ */
+struct klp_ccp_pol_str
+{
+  const char *s;
+  size_t len;
+};
+
+/*
+ * Gets passed to each operation for reporting diagnostics, which will
+ * be amended with location information. Reporting any error makes the
+ * operation fail and its result get ignored.
+ */
+struct klp_ccp_pol_reporter
+{
+  void *ctx;
+  void (*warning)(void *ctx, struct klp_ccp_pol_str msg);
+  void (*error)(void *ctx, struct klp_ccp_pol_str msg);
+};
+
+enum klp_ccp_pol_linkage
+{
+  KLP_CCP_POL_LINKAGE_UNSPECIFIED,
+  KLP_CCP_POL_LINKAGE_INTERNAL,
+  KLP_CCP_POL_LINKAGE_EXTERNAL,
+};
+
+enum klp_ccp_pol_linkage_change
+{
+  KLP_CCP_POL_KEEP_LINKAGE,
+  KLP_CCP_POL_MAKE_INTERNAL,
+  KLP_CCP_POL_MAKE_EXTERNAL,
+};
+
+enum klp_ccp_pol_sym_kind
+{
+  KLP_CCP_POL_SYM_FUNCTION,
+  KLP_CCP_POL_SYM_OBJECT,
+};
+
+struct klp_ccp_pol_src_loc
+{
+  struct klp_ccp_pol_str filename;
+  unsigned long line;
+  unsigned long column;
+};
+
+/*
+ * Symbol modification returned by a plugin. An empty new_name means
+ * no rename. It must stay valid until the next call into the plugin.
+ */
+struct klp_ccp_pol_sym_mod
+{
+  struct klp_ccp_pol_str new_name;
+  enum klp_ccp_pol_linkage_change new_linkage;
+  int make_pointer;
+};
+
+struct klp_ccp_pol_plugin_ops
+{
+  unsigned int abi_version;
+
+  /* Optional, only --patched-functions get considered if NULL. */
+  int (*is_patched)(const struct klp_ccp_pol_reporter *r,
+		    struct klp_ccp_pol_str fun);
+
+  int (*may_include_header)(const struct klp_ccp_pol_reporter *r,
+			    struct klp_ccp_pol_str header,
+			    int is_pre_include);
+
+  /*
+   * For functions which are only declared, but not defined, linkage
+   * is unspecified and def_loc is NULL.
+   */
+  int (*can_externalize_fun)(const struct klp_ccp_pol_reporter *r,
+			     struct klp_ccp_pol_str fun,
+			     enum klp_ccp_pol_linkage linkage,
+			     const struct klp_ccp_pol_src_loc *def_loc);
+
+  int (*shall_externalize_fun)(const struct klp_ccp_pol_reporter *r,
+			       struct klp_ccp_pol_str fun,
+			       int from_header);
+
+  int (*shall_externalize_obj)(const struct klp_ccp_pol_reporter *r,
+			       struct klp_ccp_pol_str obj);
+
+  /*
+   * The three operations below get retried with an incremented
+   * retries count as long as the new name returned conflicts with
+   * some existing identifier.
+   */
+  void (*modify_externalized_sym)(const struct klp_ccp_pol_reporter *r,
+				  enum klp_ccp_pol_sym_kind kind,
+				  struct klp_ccp_pol_str name,
+				  unsigned int retries,
+				  struct klp_ccp_pol_sym_mod *mod);
+
+  /* mod->make_pointer is ignored. */
+  void (*modify_patched_fun_sym)(const struct klp_ccp_pol_reporter *r,
+				 struct klp_ccp_pol_str fun,
+				 unsigned int retries,
+				 struct klp_ccp_pol_sym_mod *mod);
+
+  void (*rename_rewritten_fun)(const struct klp_ccp_pol_reporter *r,
+			       struct klp_ccp_pol_str fun,
+			       unsigned int retries,
+			       struct klp_ccp_pol_str *new_name);
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -22,6 +22,34 @@ using namespace klp::ccp;
 
 lp_creation_policy::~lp_creation_policy() noexcept = default;
 
+std::vector<bool> lp_creation_policy::
+are_patched(const std::vector<const ast::function_definition*> &fds,
+	    code_remarks &remarks) const
+{
+  std::vector<bool> result;
+  result.reserve(fds.size());
+  for (const auto fd : fds)
+    result.push_back(is_patched(*fd, remarks));
+  return result;
+}
+
+std::vector<bool> lp_creation_policy::
+are_headers_eligible
+	(const std::vector<const pp_result::header_inclusion_child*> &hs,
+	 code_remarks &remarks) const
+{
+  std::vector<bool> result;
+  result.reserve(hs.size());
+  for (const auto h : hs)
+    result.push_back(is_header_eligible(*h, remarks));
+  return result;
+}
+
+void lp_creation_policy::
+prefetch_function_externalizability
+	(const std::vector<const ast::function_definition*>&) const
+{}
+
 
 lp_creation_policy::symbol_modification::symbol_modification()
   : new_linkage{linkage_change::lc_none}
@@ -21,6 +21,7 @@
 
 #include <string>
 #include <set>
+#include <vector>
 #include "pp_result.hh"
 
 namespace klp
@@ -53,6 +54,18 @@ namespace klp
       is_header_eligible(const pp_result::header_inclusion_child &h,
 			 code_remarks &remarks) const = 0;
 
+      // Batched variants of the above, answering a whole list of
+      // queries at once. The default implementations simply ask for
+      // each individual one in turn.
+      virtual std::vector<bool>
+      are_patched(const std::vector<const ast::function_definition*> &fds,
+		  code_remarks &remarks) const;
+
+      virtual std::vector<bool>
+      are_headers_eligible
+		(const std::vector<const pp_result::header_inclusion_child*> &hs,
+		 code_remarks &remarks) const;
+
       virtual bool
       is_function_externalizable(const ast::function_definition &fd,
 				 code_remarks &remarks) const = 0;
@@ -61,6 +74,14 @@ namespace klp
       is_function_externalizable(const ast::init_declarator &id,
 				 code_remarks &remarks) const = 0;
 
+      // Hint that the externalizability of the given function
+      // definitions is likely to get asked for soon. Implementations
+      // may answer these speculatively, but must not report anything
+      // before the individual query gets actually made.
+      virtual void
+      prefetch_function_externalizability
+		(const std::vector<const ast::function_definition*> &fds) const;
+
       virtual bool
       is_function_externalization_preferred(const ast::function_definition &fd,
 					    const bool in_eligible_headers,
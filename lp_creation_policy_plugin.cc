@@ -0,0 +1,491 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include "lp_creation_policy_plugin.hh"
+#include "code_remarks.hh"
+#include "lp_except.hh"
+#include "ast.hh"
+#include "raw_pp_token.hh"
+
+using namespace klp::ccp;
+
+static bool is_identifier(const klp_ccp_pol_str &s) noexcept
+{
+  for (std::size_t j = 0; j < s.len; ++j) {
+    const char c = s.s[j];
+    if (!(c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+	  (j && c >= '0' && c <= '9'))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool
+to_linkage_change(const klp_ccp_pol_linkage_change pol_lc,
+		  lp_creation_policy::symbol_modification::linkage_change &lc)
+  noexcept
+{
+  typedef lp_creation_policy::symbol_modification::linkage_change
+    linkage_change;
+
+  switch (pol_lc) {
+  case KLP_CCP_POL_KEEP_LINKAGE:
+    lc = linkage_change::lc_none;
+    return true;
+
+  case KLP_CCP_POL_MAKE_INTERNAL:
+    lc = linkage_change::lc_make_static;
+    return true;
+
+  case KLP_CCP_POL_MAKE_EXTERNAL:
+    lc = linkage_change::lc_make_extern;
+    return true;
+  }
+
+  return false;
+}
+
+
+lp_creation_policy_plugin::_reporter::_reporter() noexcept
+{
+  _r.ctx = this;
+  _r.warning = _warning;
+  _r.error = _error;
+}
+
+void lp_creation_policy_plugin::_reporter::check() const
+{
+  if (_e)
+    std::rethrow_exception(_e);
+}
+
+void lp_creation_policy_plugin::_reporter::
+add_warnings(std::vector<std::string> &to) const
+{
+  for (const auto &w : warnings) {
+    if (std::find(to.cbegin(), to.cend(), w) == to.cend())
+      to.push_back(w);
+  }
+}
+
+void lp_creation_policy_plugin::_reporter::_warning(void *ctx,
+						      klp_ccp_pol_str msg)
+  noexcept
+{
+  _reporter &r = *static_cast<_reporter *>(ctx);
+  try {
+    r.warnings.emplace_back(msg.s, msg.len);
+  } catch (...) {
+    if (!r._e)
+      r._e = std::current_exception();
+  }
+}
+
+void lp_creation_policy_plugin::_reporter::_error(void *ctx,
+						    klp_ccp_pol_str msg)
+  noexcept
+{
+  _reporter &r = *static_cast<_reporter *>(ctx);
+  try {
+    r.errors.emplace_back(msg.s, msg.len);
+  } catch (...) {
+    if (!r._e)
+      r._e = std::current_exception();
+  }
+}
+
+
+lp_creation_policy_plugin::
+lp_creation_policy_plugin(const pp_result &pp_result,
+			  std::vector<std::string> &&patched_functions,
+			  const policy_plugin &plugin)
+  : _pp_result(pp_result),
+    _patched_functions(std::move(patched_functions)),
+    _ops(plugin.get_ops())
+{}
+
+lp_creation_policy_plugin::~lp_creation_policy_plugin() noexcept
+{}
+
+bool
+lp_creation_policy_plugin::is_patched(const ast::function_definition &fd,
+				      code_remarks &remarks) const
+{
+  const pp_token_index id_tok = _get_id_tok(fd);
+  if (std::find(_patched_functions.cbegin(),
+		_patched_functions.cend(),
+		_get_id(id_tok))
+      != _patched_functions.cend()) {
+    return true;
+  }
+
+  if (_ops.is_patched) {
+    _reporter r;
+    const int result = _ops.is_patched(r.get(), _to_pol_str(_get_id(id_tok)));
+    _handle_remarks(id_tok, r, remarks);
+    return result;
+  }
+
+  return false;
+}
+
+bool lp_creation_policy_plugin::
+is_header_eligible(const pp_result::header_inclusion_root &pre_include,
+		   code_remarks &remarks) const
+{
+  _reporter r;
+  const int result =
+    _ops.may_include_header(r.get(), _to_pol_str(pre_include.get_filename()),
+			    true);
+  r.check();
+  _handle_remarks(r.warnings, r.errors, remarks,
+		  pre_include, range_in_file{0});
+  return result;
+}
+
+bool lp_creation_policy_plugin::
+is_header_eligible(const pp_result::header_inclusion_child &h,
+		   code_remarks &remarks) const
+{
+  _reporter r;
+  const int result =
+    _ops.may_include_header(r.get(), _to_pol_str(h.get_filename()), false);
+  r.check();
+  _handle_remarks(r.warnings, r.errors, remarks,
+		  _pp_result, h.get_directive_range());
+  return result;
+}
+
+bool lp_creation_policy_plugin::
+is_function_externalizable(const ast::function_definition &fd,
+			   code_remarks &remarks) const
+{
+  const pp_token_index id_tok = _get_id_tok(fd);
+
+  klp_ccp_pol_linkage linkage = KLP_CCP_POL_LINKAGE_UNSPECIFIED;
+  switch (fd.get_linkage().get_linkage_kind()) {
+  case ast::linkage::linkage_kind::internal:
+    linkage = KLP_CCP_POL_LINKAGE_INTERNAL;
+    break;
+
+  case ast::linkage::linkage_kind::external:
+    linkage = KLP_CCP_POL_LINKAGE_EXTERNAL;
+    break;
+
+  case ast::linkage::linkage_kind::none:
+    /* fall through */
+  case ast::linkage::linkage_kind::nested_fun_auto:
+    assert(0);
+    __builtin_unreachable();
+  }
+
+  const raw_pp_token_index &raw_id_tok
+    = (_pp_result.pp_tokens_range_to_raw(pp_tokens_range{id_tok, id_tok + 1})
+       .begin);
+  const auto id_tok_source =
+    _pp_result.intersecting_sources_begin(raw_pp_tokens_range{raw_id_tok});
+  assert(id_tok_source !=
+	 (_pp_result.intersecting_sources_end
+	  (raw_pp_tokens_range{raw_id_tok})));
+  const auto id_tok_line_col
+    = (id_tok_source->offset_to_line_col
+       (_pp_result.get_raw_tokens()[raw_id_tok].get_range_in_file().begin));
+
+  klp_ccp_pol_src_loc def_loc;
+  def_loc.filename = _to_pol_str(id_tok_source->get_filename());
+  def_loc.line = id_tok_line_col.first;
+  def_loc.column = id_tok_line_col.second;
+
+  _reporter r;
+  const int result =
+    _ops.can_externalize_fun(r.get(), _to_pol_str(_get_id(id_tok)), linkage,
+			     &def_loc);
+  _handle_remarks(id_tok, r, remarks);
+  return result;
+}
+
+bool lp_creation_policy_plugin::
+is_function_externalizable(const ast::init_declarator &id,
+			   code_remarks &remarks) const
+{
+  const pp_token_index id_tok = _get_id_tok(id);
+  _reporter r;
+  const int result =
+    _ops.can_externalize_fun(r.get(), _to_pol_str(_get_id(id_tok)),
+			     KLP_CCP_POL_LINKAGE_UNSPECIFIED, nullptr);
+  _handle_remarks(id_tok, r, remarks);
+  return result;
+}
+
+bool lp_creation_policy_plugin::
+is_function_externalization_preferred(const ast::function_definition &fd,
+				      const bool in_eligible_headers,
+				      code_remarks &remarks) const
+{
+  const pp_token_index id_tok = _get_id_tok(fd);
+  _reporter r;
+  const int result =
+    _ops.shall_externalize_fun(r.get(), _to_pol_str(_get_id(id_tok)),
+			       in_eligible_headers);
+  _handle_remarks(id_tok, r, remarks);
+  return result;
+}
+
+bool lp_creation_policy_plugin::
+shall_externalize_object(const ast::init_declarator &id,
+			 code_remarks &remarks) const
+{
+  const pp_token_index id_tok = _get_id_tok(id);
+  _reporter r;
+  const int result =
+    _ops.shall_externalize_obj(r.get(), _to_pol_str(_get_id(id_tok)));
+  _handle_remarks(id_tok, r, remarks);
+  return result;
+}
+
+lp_creation_policy::externalized_symbol_modification
+lp_creation_policy_plugin::
+get_sym_mod_for_externalized_fun(const ast::direct_declarator_id &ddid,
+				 const allocated_ids_type &allocated_ids,
+				 code_remarks &remarks) const
+{
+  const pp_token_index id_tok = _get_id_tok(ddid);
+  return _get_sym_mod_for_externalized(id_tok, KLP_CCP_POL_SYM_FUNCTION,
+				       allocated_ids, remarks);
+}
+
+lp_creation_policy::symbol_modification lp_creation_policy_plugin::
+get_sym_mod_for_patched_fun(const ast::function_definition &fd,
+			    const allocated_ids_type &allocated_ids,
+			    code_remarks &remarks) const
+{
+  const pp_token_index id_tok = _get_id_tok(fd);
+
+  std::vector<std::string> warnings;
+  for (unsigned int j = 0; j < _MAX_RENAME_RETRIES; ++j) {
+    _reporter r;
+    klp_ccp_pol_sym_mod mod = {};
+    _ops.modify_patched_fun_sym(r.get(), _to_pol_str(_get_id(id_tok)), j,
+				&mod);
+    r.check();
+
+    std::string new_name = _check_new_name(id_tok, mod.new_name, r);
+    symbol_modification::linkage_change lc;
+    if (!to_linkage_change(mod.new_linkage, lc))
+      r.errors.push_back("invalid linkage change returned by policy plugin");
+
+    r.add_warnings(warnings);
+    if (!r.errors.empty())
+      _handle_remarks(warnings, r.errors, remarks, _pp_result, id_tok);
+
+    if (new_name.empty() || !allocated_ids.count(new_name)) {
+      _handle_remarks(warnings, std::vector<std::string>{}, remarks,
+		      _pp_result, id_tok);
+      return symbol_modification{std::move(new_name), lc};
+    }
+  }
+
+  _handle_retries_exceeded(id_tok, "patched", warnings, remarks);
+  __builtin_unreachable();
+}
+
+std::string lp_creation_policy_plugin::
+rename_rewritten_closure_fun(const ast::function_definition &fd,
+			     const allocated_ids_type &allocated_ids,
+			     code_remarks &remarks) const
+{
+  const pp_token_index id_tok = _get_id_tok(fd);
+
+  std::vector<std::string> warnings;
+  for (unsigned int j = 0; j < _MAX_RENAME_RETRIES; ++j) {
+    _reporter r;
+    klp_ccp_pol_str pol_new_name = {};
+    _ops.rename_rewritten_fun(r.get(), _to_pol_str(_get_id(id_tok)), j,
+			      &pol_new_name);
+    r.check();
+
+    std::string new_name = _check_new_name(id_tok, pol_new_name, r);
+
+    r.add_warnings(warnings);
+    if (!r.errors.empty())
+      _handle_remarks(warnings, r.errors, remarks, _pp_result, id_tok);
+
+    if (new_name.empty() || !allocated_ids.count(new_name)) {
+      _handle_remarks(warnings, std::vector<std::string>{}, remarks,
+		      _pp_result, id_tok);
+      return new_name;
+    }
+  }
+
+  _handle_retries_exceeded(id_tok, "rewritten", warnings, remarks);
+  __builtin_unreachable();
+}
+
+lp_creation_policy::externalized_symbol_modification
+lp_creation_policy_plugin::
+get_sym_mod_for_externalized_obj(const ast::init_declarator &id,
+				 const allocated_ids_type &allocated_ids,
+				 code_remarks &remarks) const
+{
+  const pp_token_index id_tok = _get_id_tok(id);
+  return _get_sym_mod_for_externalized(id_tok, KLP_CCP_POL_SYM_OBJECT,
+				       allocated_ids, remarks);
+}
+
+lp_creation_policy::externalized_symbol_modification
+lp_creation_policy_plugin::
+_get_sym_mod_for_externalized(const pp_token_index id_tok,
+			      const klp_ccp_pol_sym_kind kind,
+			      const allocated_ids_type &allocated_ids,
+			      code_remarks &remarks) const
+{
+  std::vector<std::string> warnings;
+  for (unsigned int j = 0; j < _MAX_RENAME_RETRIES; ++j) {
+    _reporter r;
+    klp_ccp_pol_sym_mod mod = {};
+    _ops.modify_externalized_sym(r.get(), kind, _to_pol_str(_get_id(id_tok)),
+				 j, &mod);
+    r.check();
+
+    std::string new_name = _check_new_name(id_tok, mod.new_name, r);
+    symbol_modification::linkage_change lc;
+    if (!to_linkage_change(mod.new_linkage, lc))
+      r.errors.push_back("invalid linkage change returned by policy plugin");
+
+    r.add_warnings(warnings);
+    if (!r.errors.empty())
+      _handle_remarks(warnings, r.errors, remarks, _pp_result, id_tok);
+
+    if (new_name.empty() || !allocated_ids.count(new_name)) {
+      _handle_remarks(warnings, std::vector<std::string>{}, remarks,
+		      _pp_result, id_tok);
+      return externalized_symbol_modification{
+		std::move(new_name), lc, mod.make_pointer != 0
+	     };
+    }
+  }
+
+  _handle_retries_exceeded(id_tok, "externalized", warnings, remarks);
+  __builtin_unreachable();
+}
+
+const std::string&
+lp_creation_policy_plugin::_get_id(const pp_token_index id_tok) const noexcept
+{
+  return _pp_result.get_pp_tokens()[id_tok].get_value();
+}
+
+klp_ccp_pol_str lp_creation_policy_plugin::_to_pol_str(const std::string &s)
+  noexcept
+{
+  klp_ccp_pol_str pol_s;
+  pol_s.s = s.data();
+  pol_s.len = s.size();
+  return pol_s;
+}
+
+pp_token_index lp_creation_policy_plugin::
+_get_id_tok(const ast::init_declarator &id) noexcept
+{
+  return _get_id_tok(id.get_declarator().get_direct_declarator_id());
+}
+
+pp_token_index lp_creation_policy_plugin::
+_get_id_tok(const ast::function_definition &fd) noexcept
+{
+  return _get_id_tok(fd.get_declarator().get_direct_declarator_id());
+}
+
+pp_token_index lp_creation_policy_plugin::
+_get_id_tok(const ast::direct_declarator_id &ddid) noexcept
+{
+  return ddid.get_id_tok();
+}
+
+template <typename... loc_types>
+void lp_creation_policy_plugin::
+_handle_remarks(const std::vector<std::string> &warnings,
+		const std::vector<std::string> &errors,
+		code_remarks &remarks,
+		const loc_types&... loc)
+{
+  for (const auto &w : warnings) {
+    code_remark remark{code_remark::severity::warning, w, loc...};
+    remarks.add(std::move(remark));
+  }
+
+  if (!errors.empty()) {
+    for (const auto &e : errors) {
+      code_remark remark{code_remark::severity::fatal, e, loc...};
+      remarks.add(remark);
+    }
+
+    code_remark remark{code_remark::severity::fatal, errors.front(), loc...};
+    throw lp_except(std::move(remark));
+  }
+}
+
+void lp_creation_policy_plugin::_handle_remarks(const pp_token_index id_tok,
+						const _reporter &r,
+						code_remarks &remarks) const
+{
+  r.check();
+  _handle_remarks(r.warnings, r.errors, remarks, _pp_result, id_tok);
+}
+
+std::string lp_creation_policy_plugin::
+_check_new_name(const pp_token_index id_tok,
+		const klp_ccp_pol_str &new_name,
+		_reporter &r) const
+{
+  if (!new_name.len)
+    return std::string{};
+
+  if (!new_name.s || !is_identifier(new_name)) {
+    r.errors.push_back("invalid identifier returned by policy plugin");
+    return std::string{};
+  }
+
+  std::string s{new_name.s, new_name.len};
+  if (s == _get_id(id_tok))
+    s.clear();
+  return s;
+}
+
+void lp_creation_policy_plugin::
+_handle_retries_exceeded(const pp_token_index id_tok,
+			 const char *what,
+			 const std::vector<std::string> &warnings,
+			 code_remarks &remarks) const
+{
+  _handle_remarks(warnings, std::vector<std::string>{}, remarks,
+		  _pp_result, id_tok);
+
+  code_remark remark{
+	code_remark::severity::fatal,
+	(std::string("exceeded maximum retries for renaming ") + what +
+	 " \"" + _get_id(id_tok) + "\""),
+	_pp_result,
+	id_tok
+  };
+  remarks.add(remark);
+  throw lp_except(std::move(remark));
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef LP_CREATION_POLICY_PLUGIN_HH
+#define LP_CREATION_POLICY_PLUGIN_HH
+
+#include <exception>
+#include "lp_creation_policy.hh"
+#include "policy_plugin.hh"
+
+namespace klp
+{
+  namespace ccp
+  {
+    namespace ast
+    {
+      class function_definition;
+      class init_declarator;
+      class direct_declarator_id;
+    }
+
+    class lp_creation_policy_plugin final : public lp_creation_policy
+    {
+    public:
+      lp_creation_policy_plugin(const pp_result &pp_result,
+				std::vector<std::string> &&patched_functions,
+				const policy_plugin &plugin);
+
+      virtual ~lp_creation_policy_plugin() noexcept override;
+
+      virtual bool
+      is_patched(const ast::function_definition &fd,
+		 code_remarks &remarks) const override;
+
+      virtual bool
+      is_header_eligible(const pp_result::header_inclusion_root &pre_include,
+			 code_remarks &remarks) const override;
+
+      virtual bool
+      is_header_eligible(const pp_result::header_inclusion_child &h,
+			 code_remarks &remarks) const override;
+
+      virtual bool
+      is_function_externalizable(const ast::function_definition &fd,
+				 code_remarks &remarks) const override;
+
+      virtual bool
+      is_function_externalizable(const ast::init_declarator &id,
+				 code_remarks &remarks) const override;
+
+      virtual bool
+      is_function_externalization_preferred(const ast::function_definition &fd,
+					    const bool in_eligible_headers,
+					    code_remarks &remarks)
+	const override;
+
+      virtual bool
+      shall_externalize_object(const ast::init_declarator &id,
+			       code_remarks &remarks) const override;
+
+      virtual externalized_symbol_modification
+      get_sym_mod_for_externalized_fun(const ast::direct_declarator_id &ddid,
+				       const allocated_ids_type &allocated_ids,
+				       code_remarks &remarks) const override;
+
+      virtual symbol_modification
+      get_sym_mod_for_patched_fun(const ast::function_definition &fd,
+				  const allocated_ids_type &allocated_ids,
+				  code_remarks &remarks) const override;
+
+      virtual std::string
+      rename_rewritten_closure_fun(const ast::function_definition &fd,
+				   const allocated_ids_type &allocated_ids,
+				   code_remarks &remarks) const override;
+
+      virtual externalized_symbol_modification
+      get_sym_mod_for_externalized_obj(const ast::init_declarator &id,
+				       const allocated_ids_type &allocated_ids,
+				       code_remarks &remarks) const override;
+
+    private:
+      static constexpr unsigned int _MAX_RENAME_RETRIES = 128;
+
+      // Collects what a plugin operation reports through the
+      // klp_ccp_pol_reporter interface.
+      class _reporter
+      {
+      public:
+	_reporter() noexcept;
+
+	_reporter(const _reporter&) = delete;
+	_reporter& operator=(const _reporter&) = delete;
+
+	const klp_ccp_pol_reporter* get() const noexcept
+	{ return &_r; }
+
+	// Rethrows anything caught in the callbacks, to be called
+	// once the plugin operation has returned.
+	void check() const;
+
+	void add_warnings(std::vector<std::string> &warnings) const;
+
+	std::vector<std::string> warnings;
+	std::vector<std::string> errors;
+
+      private:
+	static void _warning(void *ctx, klp_ccp_pol_str msg) noexcept;
+	static void _error(void *ctx, klp_ccp_pol_str msg) noexcept;
+
+	klp_ccp_pol_reporter _r;
+	std::exception_ptr _e;
+      };
+
+      externalized_symbol_modification
+      _get_sym_mod_for_externalized(const pp_token_index id_tok,
+				    const klp_ccp_pol_sym_kind kind,
+				    const allocated_ids_type &allocated_ids,
+				    code_remarks &remarks) const;
+
+      const std::string& _get_id(const pp_token_index id_tok) const noexcept;
+
+      static klp_ccp_pol_str _to_pol_str(const std::string &s) noexcept;
+
+      static pp_token_index _get_id_tok(const ast::init_declarator &id)
+	noexcept;
+      static pp_token_index _get_id_tok(const ast::function_definition &fd)
+	noexcept;
+      static pp_token_index _get_id_tok(const ast::direct_declarator_id &ddid)
+	noexcept;
+
+      template <typename... loc_types>
+      static void _handle_remarks(const std::vector<std::string> &warnings,
+				  const std::vector<std::string> &errors,
+				  code_remarks &remarks,
+				  const loc_types&... loc);
+
+      void _handle_remarks(const pp_token_index id_tok,
+			   const _reporter &r,
+			   code_remarks &remarks) const;
+
+      std::string _check_new_name(const pp_token_index id_tok,
+				  const klp_ccp_pol_str &new_name,
+				  _reporter &r) const;
+
+      void _handle_retries_exceeded(const pp_token_index id_tok,
+				    const char *what,
+				    const std::vector<std::string> &warnings,
+				    code_remarks &remarks) const;
+
+      const pp_result &_pp_result;
+      std::vector<std::string> _patched_functions;
+      const klp_ccp_pol_plugin_ops &_ops;
+    };
+  }
+}
+
+#endif
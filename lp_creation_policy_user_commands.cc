@@ -72,16 +72,46 @@ lp_creation_policy_user_commands::is_patched(const ast::function_definition &fd,
     auto i = _pol_cmd_is_patched->execute(std::move(args), _envp,
 					  std::regex("(YES|NO)"));
     i.wait();
-    _handle_remarks(id_tok, i.get_warnings(), i.get_errors(), remarks);
+    return _handle_yes_no_result(id_tok, i, remarks);
+  }
+
+  return false;
+}
+
+std::vector<bool> lp_creation_policy_user_commands::
+are_patched(const std::vector<const ast::function_definition*> &fds,
+	    code_remarks &remarks) const
+{
+  std::vector<bool> result(fds.size(), false);
+
+  // Only those not on the list of patched functions need asking.
+  std::vector<std::size_t> queried;
+  std::vector<std::vector<std::string>> queries;
+  for (std::size_t j = 0; j < fds.size(); ++j) {
+    const std::string &name =
+      _pp_result.get_pp_tokens()[_get_id_tok(*fds[j])].get_value();
+    if (std::find(_patched_functions.cbegin(), _patched_functions.cend(),
+		  name) != _patched_functions.cend()) {
+      result[j] = true;
+    } else if (_pol_cmd_is_patched) {
+      queried.push_back(j);
+      queries.push_back(std::vector<std::string>{name});
+    }
+  }
 
-    if (i.get_matched_result()[1].str() == "YES")
-      return true;
+  if (queries.empty())
+    return result;
 
-    assert(i.get_matched_result()[1].str() == "NO");
-    return false;
+  const std::vector<user_policy_command::instance> instances =
+    _pol_cmd_is_patched->execute_batch(queries, _envp,
+				       std::regex("(YES|NO)"));
+  for (std::size_t k = 0; k < queried.size(); ++k) {
+    const std::size_t j = queried[k];
+    result[j] = _handle_yes_no_result(_get_id_tok(*fds[j]), instances[k],
+				      remarks);
   }
 
-  return false;
+  return result;
 }
 
 bool lp_creation_policy_user_commands::
@@ -145,37 +175,69 @@ is_header_eligible(const pp_result::header_inclusion_child &h,
   auto i = _pol_cmd_may_include_header.execute(std::move(args), _envp,
 					       std::regex("(YES|NO)"));
   i.wait();
+  return _handle_header_eligible_result(h, i, remarks);
+}
 
-  for (const auto &w : i.get_warnings()) {
-    code_remark remark{
-	code_remark::severity::warning,
-	w,
-	_pp_result,
-	h.get_directive_range()
-    };
-    remarks.add(std::move(remark));
+std::vector<bool> lp_creation_policy_user_commands::
+are_headers_eligible
+	(const std::vector<const pp_result::header_inclusion_child*> &hs,
+	 code_remarks &remarks) const
+{
+  std::vector<std::vector<std::string>> queries;
+  queries.reserve(hs.size());
+  for (const auto h : hs)
+    queries.push_back(std::vector<std::string>{h->get_filename()});
+
+  const std::vector<user_policy_command::instance> instances =
+    _pol_cmd_may_include_header.execute_batch(queries, _envp,
+					      std::regex("(YES|NO)"));
+
+  std::vector<bool> result;
+  result.reserve(hs.size());
+  for (std::size_t j = 0; j < hs.size(); ++j) {
+    result.push_back(_handle_header_eligible_result(*hs[j], instances[j],
+						    remarks));
   }
 
-  if (!i.get_errors().empty()) {
-    for (const auto &e : i.get_errors()) {
-      code_remark remark{
-	code_remark::severity::fatal,
-	e,
-	_pp_result,
-	h.get_directive_range()
-      };
-      remarks.add(remark);
-    }
+  return result;
+}
 
-    code_remark remark{
-	code_remark::severity::fatal,
-	i.get_errors().front(),
-	_pp_result,
-	h.get_directive_range()
-    };
-    throw lp_except(std::move(remark));
+bool lp_creation_policy_user_commands::
+is_function_externalizable(const ast::function_definition &fd,
+			   code_remarks &remarks) const
+{
+  const pp_token_index id_tok = _get_id_tok(fd);
+
+  const auto it_prefetched = _prefetched_externalizability.find(&fd);
+  if (it_prefetched != _prefetched_externalizability.end()) {
+    const _prefetched_answer a = std::move(it_prefetched->second);
+    _prefetched_externalizability.erase(it_prefetched);
+    _handle_remarks(id_tok, a.warnings, a.errors, remarks);
+    return a.result;
   }
 
+  auto i = _pol_cmd_can_externalize_fun.execute
+		(_get_can_externalize_fun_args(fd), _envp,
+		 std::regex("(YES|NO)"));
+  i.wait();
+  return _handle_yes_no_result(id_tok, i, remarks);
+}
+
+bool lp_creation_policy_user_commands::
+is_function_externalizable(const ast::init_declarator &id,
+			   code_remarks &remarks) const
+{
+  std::vector<std::string> args;
+  args.reserve(1);
+
+  const pp_token_index id_tok = _get_id_tok(id);
+  args.push_back(_pp_result.get_pp_tokens()[id_tok].get_value());
+
+  auto i = _pol_cmd_can_externalize_fun.execute(std::move(args), _envp,
+						std::regex("(YES|NO)"));
+  i.wait();
+  _handle_remarks(id_tok, i.get_warnings(), i.get_errors(), remarks);
+
   if (i.get_matched_result()[1].str() == "YES")
     return true;
 
@@ -183,9 +245,47 @@ is_header_eligible(const pp_result::header_inclusion_child &h,
   return false;
 }
 
-bool lp_creation_policy_user_commands::
-is_function_externalizable(const ast::function_definition &fd,
-			   code_remarks &remarks) const
+void lp_creation_policy_user_commands::
+prefetch_function_externalizability
+	(const std::vector<const ast::function_definition*> &fds) const
+{
+  std::vector<const ast::function_definition*> queried;
+  std::vector<std::vector<std::string>> queries;
+  for (const auto fd : fds) {
+    if (_prefetched_externalizability.count(fd))
+      continue;
+
+    queried.push_back(fd);
+    queries.push_back(_get_can_externalize_fun_args(*fd));
+  }
+
+  if (queries.empty())
+    return;
+
+  std::vector<user_policy_command::instance> instances;
+  try {
+    instances = _pol_cmd_can_externalize_fun.execute_batch
+		  (queries, _envp, std::regex("(YES|NO)"));
+  } catch (const user_policy_command::execution_except&) {
+    // Leave it to the individual queries to report the failure, if
+    // the answer turns out to be needed at all.
+    return;
+  }
+
+  for (std::size_t j = 0; j < queried.size(); ++j) {
+    const user_policy_command::instance &i = instances[j];
+    _prefetched_answer a;
+    a.warnings = i.get_warnings();
+    a.errors = i.get_errors();
+    a.result = (a.errors.empty() &&
+		i.get_matched_result()[1].str() == "YES");
+    _prefetched_externalizability.insert(std::make_pair(queried[j],
+							std::move(a)));
+  }
+}
+
+std::vector<std::string> lp_creation_policy_user_commands::
+_get_can_externalize_fun_args(const ast::function_definition &fd) const
 {
   std::vector<std::string> args;
   args.reserve(3);
@@ -224,38 +324,7 @@ is_function_externalizable(const ast::function_definition &fd,
 		 + ":" + std::to_string(id_tok_line_col.first)
 		 + ":" + std::to_string(id_tok_line_col.second));
 
-  auto i = _pol_cmd_can_externalize_fun.execute(std::move(args), _envp,
-						std::regex("(YES|NO)"));
-  i.wait();
-  _handle_remarks(id_tok, i.get_warnings(), i.get_errors(), remarks);
-
-  if (i.get_matched_result()[1].str() == "YES")
-    return true;
-
-  assert(i.get_matched_result()[1].str() == "NO");
-  return false;
-}
-
-bool lp_creation_policy_user_commands::
-is_function_externalizable(const ast::init_declarator &id,
-			   code_remarks &remarks) const
-{
-  std::vector<std::string> args;
-  args.reserve(1);
-
-  const pp_token_index id_tok = _get_id_tok(id);
-  args.push_back(_pp_result.get_pp_tokens()[id_tok].get_value());
-
-  auto i = _pol_cmd_can_externalize_fun.execute(std::move(args), _envp,
-						std::regex("(YES|NO)"));
-  i.wait();
-  _handle_remarks(id_tok, i.get_warnings(), i.get_errors(), remarks);
-
-  if (i.get_matched_result()[1].str() == "YES")
-    return true;
-
-  assert(i.get_matched_result()[1].str() == "NO");
-  return false;
+  return args;
 }
 
 bool lp_creation_policy_user_commands::
@@ -560,3 +629,60 @@ _handle_remarks(const pp_token_index id_tok,
     throw lp_except(std::move(remark));
   }
 }
+
+bool lp_creation_policy_user_commands::
+_handle_yes_no_result(const pp_token_index id_tok,
+		      const user_policy_command::instance &i,
+		      code_remarks &remarks) const
+{
+  _handle_remarks(id_tok, i.get_warnings(), i.get_errors(), remarks);
+
+  if (i.get_matched_result()[1].str() == "YES")
+    return true;
+
+  assert(i.get_matched_result()[1].str() == "NO");
+  return false;
+}
+
+bool lp_creation_policy_user_commands::
+_handle_header_eligible_result(const pp_result::header_inclusion_child &h,
+			       const user_policy_command::instance &i,
+			       code_remarks &remarks) const
+{
+  for (const auto &w : i.get_warnings()) {
+    code_remark remark{
+	code_remark::severity::warning,
+	w,
+	_pp_result,
+	h.get_directive_range()
+    };
+    remarks.add(std::move(remark));
+  }
+
+  if (!i.get_errors().empty()) {
+    for (const auto &e : i.get_errors()) {
+      code_remark remark{
+	code_remark::severity::fatal,
+	e,
+	_pp_result,
+	h.get_directive_range()
+      };
+      remarks.add(remark);
+    }
+
+    code_remark remark{
+	code_remark::severity::fatal,
+	i.get_errors().front(),
+	_pp_result,
+	h.get_directive_range()
+    };
+    throw lp_except(std::move(remark));
+  }
+
+  if (i.get_matched_result()[1].str() == "YES")
+    return true;
+
+  assert(i.get_matched_result()[1].str() == "NO");
+  return false;
+}
+
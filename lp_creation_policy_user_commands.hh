@@ -19,6 +19,7 @@
 #ifndef LP_CREATION_POLICY_USER_COMMANDS_HH
 #define LP_CREATION_POLICY_USER_COMMANDS_HH
 
+#include <map>
 #include "lp_creation_policy.hh"
 #include "user_policy_command.hh"
 
@@ -63,6 +64,15 @@ namespace klp
       is_header_eligible(const pp_result::header_inclusion_child &h,
 			 code_remarks &remarks) const override;
 
+      virtual std::vector<bool>
+      are_patched(const std::vector<const ast::function_definition*> &fds,
+		  code_remarks &remarks) const override;
+
+      virtual std::vector<bool>
+      are_headers_eligible
+		(const std::vector<const pp_result::header_inclusion_child*> &hs,
+		 code_remarks &remarks) const override;
+
       virtual bool
       is_function_externalizable(const ast::function_definition &fd,
 				 code_remarks &remarks) const override;
@@ -71,6 +81,11 @@ namespace klp
       is_function_externalizable(const ast::init_declarator &id,
 				 code_remarks &remarks) const override;
 
+      virtual void
+      prefetch_function_externalizability
+		(const std::vector<const ast::function_definition*> &fds)
+	const override;
+
       virtual bool
       is_function_externalization_preferred(const ast::function_definition &fd,
 					    const bool in_eligible_headers,
@@ -110,6 +125,9 @@ namespace klp
 				    const allocated_ids_type &allocated_ids,
 				    code_remarks &remarks) const;
 
+      std::vector<std::string>
+      _get_can_externalize_fun_args(const ast::function_definition &fd) const;
+
       static pp_token_index _get_id_tok(const ast::init_declarator &id)
 	noexcept;
       static pp_token_index _get_id_tok(const ast::function_definition &fd)
@@ -122,6 +140,15 @@ namespace klp
 			   const std::vector<std::string> &errors,
 			   code_remarks &remarks) const;
 
+      bool _handle_yes_no_result(const pp_token_index id_tok,
+				 const user_policy_command::instance &i,
+				 code_remarks &remarks) const;
+
+      bool _handle_header_eligible_result
+		(const pp_result::header_inclusion_child &h,
+		 const user_policy_command::instance &i,
+		 code_remarks &remarks) const;
+
       const pp_result &_pp_result;
 
       char ** const _envp;
@@ -135,6 +162,18 @@ namespace klp
       const user_policy_command _pol_cmd_mod_externalized_sym;
       const user_policy_command _pol_cmd_mod_patched_fun_sym;
       const user_policy_command _pol_cmd_rename_rewritten_fun;
+
+      // Speculatively obtained answers, reported only once the
+      // corresponding query gets actually made.
+      struct _prefetched_answer
+      {
+	std::vector<std::string> warnings;
+	std::vector<std::string> errors;
+	bool result;
+      };
+
+      mutable std::map<const ast::function_definition*, _prefetched_answer>
+	_prefetched_externalizability;
     };
   }
 }
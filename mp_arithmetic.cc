@@ -18,7 +18,7 @@
 
 #include <cassert>
 #include <algorithm>
-#include <array>
+#include <cstdint>
 #include "mp_arithmetic.hh"
 
 using namespace klp::ccp::mpa;
@@ -69,56 +69,54 @@ unsigned int limb::clrsb() const noexcept
   }
 }
 
+namespace
+{
+  // Unsigned integer type twice as wide as a limb, used for the
+  // product and the quotient computations below.
+#ifdef MPA_LIMB_64
+  typedef unsigned __int128 double_limb_type;
+#else
+  typedef std::uint64_t double_limb_type;
+#endif
+
+  static_assert(std::numeric_limits<double_limb_type>::digits ==
+		2 * limb::width,
+		"double_limb_type must be twice as wide as a limb");
+
+  inline double_limb_type to_double_limb_type(const limb &high,
+					      const limb &low) noexcept
+  {
+    return (static_cast<double_limb_type>(high.value()) << limb::width |
+	    low.value());
+  }
+}
+
 bool limb::add(const bool op) noexcept
 {
-  _value += op;
-  return op && !_value;
+  return __builtin_add_overflow(_value, static_cast<limb_type>(op), &_value);
 }
 
 bool limb::add(const limb &op) noexcept
 {
-  _value += op._value;
-  return _value < op._value;
+  return __builtin_add_overflow(_value, op._value, &_value);
 }
 
 bool limb::sub(const bool op) noexcept
 {
-  _value -= op;
-  return op && !~_value;
+  return __builtin_sub_overflow(_value, static_cast<limb_type>(op), &_value);
 }
 
 bool limb::sub(const limb &op) noexcept
 {
-  const limb_type old_value = _value;
-  _value -= op._value;
-  return old_value < _value;
+  return __builtin_sub_overflow(_value, op._value, &_value);
 }
 
 const double_limb limb::operator*(const limb &op) const noexcept
 {
-  static_assert(width % 2 == 0,
-		"not implemented: limb_type width must be even");
-  const unsigned int half_width = width / 2;
-  const limb_type low_half_mask = mask(half_width)._value;
-
-  limb low((_value & low_half_mask) * (op._value & low_half_mask));
-  limb high((_value >> half_width) * (op._value >> half_width));
-
-  limb_type tmp = (_value & low_half_mask) * (op._value >> half_width);
-  bool carry = low.add(limb(tmp << half_width));
-  bool high_overflow = high.add(carry);
-  assert(!high_overflow);
-  high_overflow = high.add(limb(tmp >> half_width));
-  assert(!high_overflow);
-
-  tmp = ((_value >> half_width) * (op._value & low_half_mask));
-  carry = low.add(limb(tmp << half_width));
-  high_overflow = high.add(carry);
-  assert(!high_overflow);
-  high_overflow = high.add(limb(tmp >> half_width));
-  assert(!high_overflow);
-
-  return double_limb(high, low);
+  const double_limb_type prod =
+    static_cast<double_limb_type>(_value) * op._value;
+  return double_limb(limb(static_cast<limb_type>(prod >> width)),
+		     limb(static_cast<limb_type>(prod)));
 }
 
 
@@ -133,167 +131,113 @@ limb double_limb::div(const limb divisor)
   if (!divisor)
     throw std::invalid_argument("division by zero");
 
-  static_assert(limb::width % 2 == 0,
-		"not implemented: limb_type width must be even");
-
-  const unsigned int half_width = limb::width / 2;
-  const limb::limb_type low_half_mask = limb::mask(half_width).value();
-
-  // Division algorithm according to D. E. Knuth,
-  // c.f. limbs::operator/() for the specific case of four half limbs.
-  // The below arrays' element types are all of time limb_type
-  // but they actually represent half limbs.
-  std::array<limb::limb_type, 3> v{{
-    divisor.value() & low_half_mask,
-    divisor.value() >> half_width,
-    0, // convenience v[n]
-  }};
-
-  std::array<limb::limb_type, 5> u{{
-    _low.value() & low_half_mask,
-    _low.value() >> half_width,
-    _high.value() & low_half_mask,
-    _high.value() >> half_width,
-    0,
-  }};
-
-  const unsigned int n = v[1] ? 2 : 1;
-  const unsigned int m = 4 - n;
+  const double_limb_type u = to_double_limb_type(_high, _low);
+  const double_limb_type q = u / divisor.value();
+  const limb r(static_cast<limb::limb_type>(u - q * divisor.value()));
 
-  if (n == 1) {
-    std::array<limb::limb_type, 4> q{{0}};
-    limb::limb_type r = 0;
-    for (unsigned int __j = m + 1; __j > 0; --__j) {
-      const unsigned int j = __j - 1;
-      limb::limb_type tmp = (r << half_width) | u[j];
-      r = tmp % v[0];
-      tmp /= v[0];
-      assert(!(tmp >> half_width));
-      q[j] = tmp;
-    }
+  _low = limb(static_cast<limb::limb_type>(q));
+  _high = limb(static_cast<limb::limb_type>(q >> limb::width));
 
-    _low = limb((q[1] << half_width) | q[0]);
-    _high = limb((q[3] << half_width) | q[2]);
+  return r;
+}
 
-    return limb(r);
-  }
+impl::limbs_vector::limbs_vector() noexcept
+  : _data(_inline), _size(0), _capacity(_n_inline)
+{}
 
-  // Calculate scaling b / (v_{n-1} + 1)
-  const limb::limb_type b = static_cast<limb::limb_type>(1) << half_width;
-  const limb::limb_type d = b / (v[n - 1] + 1);
-  limb::limb_type carry = 0;
-
-  for (auto &hl : v) {
-    hl *= d;
-    hl += carry;
-    carry = hl >> half_width;
-    hl &= low_half_mask;
-  }
-  assert(!carry);
-  assert(!v[2]);
-  assert(!v[n]);
-
-  for (auto &hl : u) {
-    hl *= d;
-    hl += carry;
-    carry = hl >> half_width;
-    hl &= low_half_mask;
-  }
-  assert(!carry);
+impl::limbs_vector::limbs_vector(const size_type n, const limb &value)
+  : limbs_vector()
+{
+  reserve(n);
+  std::fill(_data, _data + n, value);
+  _size = n;
+}
 
-  // The normalization procedure guarantees that v_{n-1} >= floor(b/2)
-  // and u_{m + n} < floor(b/2).
-  assert(u[m + n] < v [n - 1]);
+impl::limbs_vector::limbs_vector(const std::initializer_list<limb> &il)
+  : limbs_vector()
+{
+  reserve(il.size());
+  std::copy(il.begin(), il.end(), _data);
+  _size = il.size();
+}
 
-  std::array<limb::limb_type, 4> q{{0}};
-  for (unsigned int __j = m + 1; __j > 0; --__j) {
-    const unsigned int j = __j - 1;
-    bool recheck = true;
-    limb::limb_type _q = (u[j + n] << half_width) | (u[j + n - 1]);
-    limb::limb_type r = _q % v[n - 1];
-    _q /= v[n - 1];
-    if (_q >> half_width) {
-      // q >= b. It follows that u[j + n] >= v[n - 1].
-      // Because u[j + n:j] / v < b, this means that
-      assert(u[j + n] == v[n - 1]);
-      _q = b - 1;
-      r = u[j + n - 1] + v[n - 1];
-      recheck = !(r >> half_width);
-    }
+impl::limbs_vector::limbs_vector(const limbs_vector &v)
+  : limbs_vector()
+{
+  reserve(v._size);
+  std::copy(v.begin(), v.end(), _data);
+  _size = v._size;
+}
 
-    while (recheck) {
-      const limb::limb_type tmp = _q * v [n - 2];
-      if ((tmp >> half_width) > r ||
-	  ((tmp >> half_width) == r && (tmp & low_half_mask) > u[j + n - 2])) {
-	--_q;
-	// An overflow will occur after <= 2 iterations.
-	r += v[n - 1];
-	recheck = !(r >> half_width);
-      } else {
-	recheck = false;
-      }
-    }
+impl::limbs_vector::limbs_vector(limbs_vector &&v) noexcept
+  : limbs_vector()
+{
+  *this = std::move(v);
+}
 
-    // Multiply and subtract
-    limb::limb_type borrow = 0;
-    for (unsigned int i = 0; i <= n; ++i) {
-      const limb::limb_type prod = v[i] * _q;
-      assert(!(borrow >> half_width));
-      assert(!(u[j + i] >> half_width));
-      limb::limb_type hlu = u[j + i] - borrow;
-      hlu -= (prod & low_half_mask);
-      borrow = ((static_cast<limb::limb_type>(1) << half_width)
-		- (hlu >> half_width));
-      borrow &= low_half_mask;
-      assert(borrow <= 2);
-      hlu &= low_half_mask;
-      borrow += (prod >> half_width);
-      assert(!(borrow >> half_width));
-      u[j + i] = hlu;
-    }
+impl::limbs_vector::~limbs_vector() noexcept
+{
+  if (!_is_inline())
+    delete[] _data;
+}
 
-    if (borrow) {
-      assert(borrow == 1);
-      // q is one too large, add v back.
-      --_q;
-      bool _carry = false;
-      for (unsigned int i = 0; i <= n; ++i) {
-	limb::limb_type hlresult = u[j + i];
-	hlresult += _carry;
-	hlresult += v[i];
-	_carry = (hlresult >> half_width) ? true : false;
-	hlresult &= low_half_mask;
-	u[j + i] = hlresult;
-      }
-      // _carry cancels borrow
-      assert(_carry);
-    }
+impl::limbs_vector& impl::limbs_vector::operator=(const limbs_vector &rhs)
+{
+  if (this == &rhs)
+    return *this;
 
-    q[j] = _q;
-  }
+  _size = 0;
+  reserve(rhs._size);
+  std::copy(rhs.begin(), rhs.end(), _data);
+  _size = rhs._size;
+  return *this;
+}
 
-  // Denormalize the remainder
-  limb::limb_type r = 0;
-  for (unsigned int __j = n; __j > 0; --__j) {
-    const unsigned int j = __j - 1;
-    limb::limb_type tmp = (r << half_width) | u[j];
-    r = tmp % d;
-    tmp /= d;
-    assert(!(tmp >> half_width));
-    u[j] = tmp;
+impl::limbs_vector& impl::limbs_vector::operator=(limbs_vector &&rhs) noexcept
+{
+  if (this == &rhs)
+    return *this;
+
+  if (!rhs._is_inline()) {
+    // Steal the heap buffer.
+    if (!_is_inline())
+      delete[] _data;
+    _data = rhs._data;
+    _capacity = rhs._capacity;
+    rhs._data = rhs._inline;
+    rhs._capacity = _n_inline;
+  } else {
+    // Any heap buffer is larger than the inline storage.
+    std::copy(rhs.begin(), rhs.end(), _data);
   }
-  assert(!r);
-#ifndef NDEBUG
-  for (unsigned int j = n; j < u.size(); ++j)
-    assert(!u[j]);
-#endif
 
-  _low = limb((q[1] << half_width) | q[0]);
-  _high = limb((q[3] << half_width) | q[2]);
+  _size = rhs._size;
+  rhs._size = 0;
+  return *this;
+}
+
+void impl::limbs_vector::reserve(const size_type n)
+{
+  if (n <= _capacity)
+    return;
+
+  limb * const data = new limb[n];
+  std::copy(begin(), end(), data);
+  if (!_is_inline())
+    delete[] _data;
+  _data = data;
+  _capacity = n;
+}
 
-  return limb((u[1] << half_width) | u[0]);
+void impl::limbs_vector::resize(const size_type n)
+{
+  reserve(n);
+  if (n > _size)
+    std::fill(_data + _size, _data + n, limb(0));
+  _size = n;
 }
 
+
 limbs::limbs() = default;
 
 limbs::limbs(const std::initializer_list<limb::limb_type> &il)
@@ -315,6 +259,10 @@ limbs::limbs(const limbs &ls)
   : _limbs(ls._limbs)
 {}
 
+limbs::limbs(limbs &&ls) noexcept
+  : _limbs(std::move(ls._limbs))
+{}
+
 limbs::limbs(_limbs_type &&ls)
   : _limbs(std::move(ls))
 {}
@@ -327,6 +275,12 @@ limbs& limbs::operator=(const limbs &rhs)
   return *this;
 }
 
+limbs& limbs::operator=(limbs &&rhs) noexcept
+{
+  _limbs = std::move(rhs._limbs);
+  return *this;
+}
+
 bool limbs::operator==(const limbs &op) const noexcept
 {
   const size_type n = std::min(size(), op.size());
@@ -492,6 +446,27 @@ limbs limbs::operator*(const limbs &op) const
 {
   const size_type m = size();
   const size_type n = op.size();
+
+  // Single limb factors, as are common for target_float
+  // significands and for the scaling in from_string(), don't need
+  // to accumulate partial products.
+  if (n == 1 || m == 1) {
+    const limbs &u = n == 1 ? *this : op;
+    const limb &v = n == 1 ? op[0] : _limbs[0];
+    _limbs_type result;
+    result.reserve(m + n);
+    limb carry(0);
+    for (const auto &l : u._limbs) {
+      double_limb t = l * v;
+      const bool t_high_overflow = t.add(carry);
+      assert(!t_high_overflow);
+      result.emplace_back(t.low());
+      carry = t.high();
+    }
+    result.emplace_back(carry);
+    return limbs(std::move(result));
+  }
+
   _limbs_type result(m, limb(0));
   result.reserve(m + n);
 
@@ -530,6 +505,22 @@ limbs::operator/(const limbs &divisor) const
   }
   const size_type m = size() - n;
 
+  if (n == 1) {
+    // Short division by a single limb, no normalization needed.
+    const limb::limb_type v = divisor[0].value();
+    _limbs_type q(m + 1, limb(0));
+    limb::limb_type r = 0;
+    for (size_type __j = m + 1; __j > 0; --__j) {
+      const size_type j = __j - 1;
+      const double_limb_type u = to_double_limb_type(limb(r), _limbs[j]);
+      const limb::limb_type _q = static_cast<limb::limb_type>(u / v);
+      r = static_cast<limb::limb_type>(u % v);
+      q[j] = limb(_q);
+    }
+
+    return std::make_pair(limbs(std::move(q)), limbs({limb(r)}));
+  }
+
   // Division algorithm from D. E. Knuth: "The Art of Computer
   // Programming", sec. 4.3.1 ("The classical algorithms").
   //
@@ -1075,7 +1066,10 @@ limbs limbs::from_size_type(size_type value)
     ls.reserve(size);
     while (value) {
       ls.emplace_back(static_cast<limb::limb_type>(value));
-      value >>= limb::width;
+      // Shift in two steps, limb::width might equal the width of
+      // size_type.
+      value >>= limb::width / 2;
+      value >>= limb::width / 2;
     }
   } else {
     ls.resize(1);
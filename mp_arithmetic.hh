@@ -37,7 +37,15 @@ namespace klp
       class limb
       {
       public:
+	// Limbs are 32 bits wide by default. Configuring with
+	// --enable-wide-limbs defines MPA_LIMB_64 and switches to 64
+	// bit limbs, with the double limb arithmetic done in unsigned
+	// __int128.
+#ifdef MPA_LIMB_64
+	typedef unsigned long long limb_type;
+#else
 	typedef unsigned int limb_type;
+#endif
 
 	static constexpr unsigned int width =
 	  std::numeric_limits<limb_type>::digits;
@@ -131,10 +139,87 @@ namespace klp
 	limb _low;
       };
 
+      namespace impl
+      {
+	// A minimal std::vector<limb> replacement which stores the
+	// values of all integer types up to 128 bits wide inline
+	// without going to the heap.
+	class limbs_vector
+	{
+	public:
+	  typedef std::size_t size_type;
+	  typedef limb* iterator;
+	  typedef const limb* const_iterator;
+
+	  limbs_vector() noexcept;
+	  limbs_vector(const size_type n, const limb &value);
+	  limbs_vector(const std::initializer_list<limb> &il);
+	  limbs_vector(const limbs_vector &v);
+	  limbs_vector(limbs_vector &&v) noexcept;
+
+	  ~limbs_vector() noexcept;
+
+	  limbs_vector& operator=(const limbs_vector &rhs);
+	  limbs_vector& operator=(limbs_vector &&rhs) noexcept;
+
+	  const limb& operator[](const size_type i) const noexcept
+	  { return _data[i]; }
+
+	  limb& operator[](const size_type i) noexcept
+	  { return _data[i]; }
+
+	  bool empty() const noexcept
+	  { return !_size; }
+
+	  size_type size() const noexcept
+	  { return _size; }
+
+	  iterator begin() noexcept
+	  { return _data; }
+
+	  iterator end() noexcept
+	  { return _data + _size; }
+
+	  const_iterator begin() const noexcept
+	  { return _data; }
+
+	  const_iterator end() const noexcept
+	  { return _data + _size; }
+
+	  const limb& back() const noexcept
+	  { return _data[_size - 1]; }
+
+	  void reserve(const size_type n);
+	  void resize(const size_type n);
+
+	  void clear() noexcept
+	  { _size = 0; }
+
+	  template<typename... args_types>
+	  void emplace_back(args_types&&... args)
+	  {
+	    if (_size == _capacity)
+	      reserve(2 * _capacity);
+	    _data[_size++] = limb(std::forward<args_types>(args)...);
+	  }
+
+	private:
+	  static constexpr size_type _n_inline = 128 / limb::width;
+
+	  bool _is_inline() const noexcept
+	  { return _data == _inline; }
+
+	  limb *_data;
+	  size_type _size;
+	  size_type _capacity;
+	  limb _inline[_n_inline];
+	};
+      }
+
       class limbs
       {
       private:
-	typedef std::vector<limb> _limbs_type;
+	typedef impl::limbs_vector _limbs_type;
 
       public:
 	typedef _limbs_type::size_type size_type;
@@ -144,8 +229,10 @@ namespace klp
 	limbs(const std::initializer_list<limb> &il);
 	explicit limbs(const size_type n);
 	limbs(const limbs &ls);
+	limbs(limbs &&ls) noexcept;
 
 	limbs& operator=(const limbs &rhs);
+	limbs& operator=(limbs &&rhs) noexcept;
 
 	bool operator==(const limbs &op) const noexcept;
 
@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "policy_answer_cache.hh"
+
+using namespace klp::ccp;
+
+struct policy_answer_cache::_header
+{
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t n_buckets_log2;
+  // Offset at which the next record gets allocated.
+  std::uint64_t end;
+};
+
+struct policy_answer_cache::_record_header
+{
+  // Offset of the next older record in the same bucket, zero if none.
+  std::uint64_t next;
+  std::uint32_t key_size;
+  std::uint32_t answer_size;
+};
+
+static const char cache_magic[8] = { 'K', 'L', 'P', 'C', 'C', 'P', 'A', 'C' };
+static const std::uint32_t cache_version = 1;
+
+// The bucket table starts right after the header, on a cache line.
+static const std::size_t buckets_offset = 64;
+
+policy_answer_cache::policy_answer_cache(const std::string &filename,
+					 const std::string &epoch)
+  : _filename(filename), _epoch(epoch), _fd(-1), _map(nullptr),
+    _map_size(buckets_offset +
+	      (sizeof(std::uint64_t) << _n_buckets_log2)),
+    _buckets(nullptr)
+{
+  static_assert(sizeof(_header) <= buckets_offset,
+		"cache file header overlaps bucket table");
+
+  auto &&fail = [&](const int err) {
+    if (_map)
+      munmap(_map, _map_size);
+    close(_fd);
+    return std::system_error(err, std::system_category(), _filename);
+  };
+
+  _fd = open(_filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (_fd < 0)
+    throw std::system_error(errno, std::system_category(), _filename);
+
+  // Serialize the initialization of a new file.
+  if (flock(_fd, LOCK_EX))
+    throw fail(errno);
+
+  struct stat st;
+  if (fstat(_fd, &st))
+    throw fail(errno);
+
+  _header h;
+  if (!st.st_size) {
+    if (ftruncate(_fd, _map_size))
+      throw fail(errno);
+
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, cache_magic, sizeof(h.magic));
+    h.version = cache_version;
+    h.n_buckets_log2 = _n_buckets_log2;
+    h.end = _map_size;
+    if (pwrite(_fd, &h, sizeof(h), 0) != sizeof(h))
+      throw fail(errno ? errno : EIO);
+
+  } else {
+    if (static_cast<std::size_t>(st.st_size) < _map_size ||
+	pread(_fd, &h, sizeof(h), 0) != sizeof(h) ||
+	std::memcmp(h.magic, cache_magic, sizeof(h.magic)) ||
+	h.version != cache_version ||
+	h.n_buckets_log2 != _n_buckets_log2) {
+      throw fail(EINVAL);
+    }
+  }
+
+  _map = mmap(nullptr, _map_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (_map == MAP_FAILED) {
+    _map = nullptr;
+    throw fail(errno);
+  }
+  _buckets = reinterpret_cast<std::uint64_t *>
+		(static_cast<char *>(_map) + buckets_offset);
+
+  if (flock(_fd, LOCK_UN))
+    throw fail(errno);
+}
+
+policy_answer_cache::~policy_answer_cache() noexcept
+{
+  munmap(_map, _map_size);
+  close(_fd);
+}
+
+bool policy_answer_cache::lookup(const std::vector<std::string> &argv,
+				 std::string &answer) const
+{
+  const std::string key = _make_key(argv);
+  const std::uint64_t head =
+    __atomic_load_n(&_buckets[_hash(key) &
+			      ((std::uint64_t{1} << _n_buckets_log2) - 1)],
+		    __ATOMIC_ACQUIRE);
+  return _find(head, 0, key, &answer);
+}
+
+void policy_answer_cache::insert(const std::vector<std::string> &argv,
+				 const std::string &answer)
+{
+  const std::string key = _make_key(argv);
+  std::uint64_t &bucket =
+    _buckets[_hash(key) & ((std::uint64_t{1} << _n_buckets_log2) - 1)];
+  std::uint64_t head = __atomic_load_n(&bucket, __ATOMIC_ACQUIRE);
+  if (_find(head, 0, key, nullptr))
+    return;
+
+  _record_header rh;
+  rh.next = head;
+  rh.key_size = key.size();
+  rh.answer_size = answer.size();
+
+  std::string record(reinterpret_cast<const char *>(&rh), sizeof(rh));
+  record += key;
+  record += answer;
+
+  // Reserve room for the record at the end of the file. Other
+  // processes can't see it before it's linked into the bucket below.
+  _header &h = *static_cast<_header *>(_map);
+  const std::uint64_t off =
+    __atomic_fetch_add(&h.end, record.size(), __ATOMIC_RELAXED);
+  if (pwrite(_fd, record.data(), record.size(), off) !=
+      static_cast<ssize_t>(record.size())) {
+    throw std::system_error(errno ? errno : EIO, std::system_category(),
+			    _filename);
+  }
+
+  while (!__atomic_compare_exchange_n(&bucket, &head, off, false,
+				      __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+    // Some other process got in first. It might have inserted the
+    // same key.
+    if (_find(head, rh.next, key, nullptr))
+      return;
+
+    rh.next = head;
+    if (pwrite(_fd, &rh.next, sizeof(rh.next), off) != sizeof(rh.next)) {
+      throw std::system_error(errno ? errno : EIO, std::system_category(),
+			      _filename);
+    }
+  }
+}
+
+std::string
+policy_answer_cache::_make_key(const std::vector<std::string> &argv) const
+{
+  std::string key = _epoch;
+  key += '\0';
+  for (const auto &arg : argv) {
+    key += arg;
+    key += '\0';
+  }
+  return key;
+}
+
+std::uint64_t policy_answer_cache::_hash(const std::string &key) noexcept
+{
+  // FNV-1a
+  std::uint64_t h = 0xcbf29ce484222325;
+  for (const char c : key) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 0x100000001b3;
+  }
+  return h;
+}
+
+bool policy_answer_cache::_find(std::uint64_t off, const std::uint64_t end_off,
+				const std::string &key,
+				std::string *answer) const
+{
+  std::string buf;
+  while (off && off != end_off) {
+    // Records only ever link to older ones at lower offsets, anything
+    // else, including short reads, means the file is corrupted and
+    // gets treated as a miss.
+    _record_header rh;
+    if (pread(_fd, &rh, sizeof(rh), off) != sizeof(rh) || rh.next >= off)
+      return false;
+
+    if (rh.key_size == key.size()) {
+      buf.resize(static_cast<std::size_t>(rh.key_size) + rh.answer_size);
+      if (pread(_fd, &buf[0], buf.size(), off + sizeof(rh)) !=
+	  static_cast<ssize_t>(buf.size())) {
+	return false;
+      }
+
+      if (!buf.compare(0, key.size(), key)) {
+	if (answer)
+	  answer->assign(buf, key.size(), std::string::npos);
+	return true;
+      }
+    }
+
+    off = rh.next;
+  }
+
+  return false;
+}
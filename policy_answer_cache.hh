@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef POLICY_ANSWER_CACHE_HH
+#define POLICY_ANSWER_CACHE_HH
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace klp
+{
+  namespace ccp
+  {
+    // On-disk cache of policy command answers, keyed by the command's
+    // full argument vector and a user supplied epoch string. It can
+    // be shared by concurrently running klp-ccp processes: the file
+    // starts with a fixed size table of hash bucket heads, which gets
+    // mapped into memory and updated atomically, followed by records
+    // which only ever get appended.
+    class policy_answer_cache
+    {
+    public:
+      policy_answer_cache(const std::string &filename,
+			  const std::string &epoch);
+
+      ~policy_answer_cache() noexcept;
+
+      policy_answer_cache(const policy_answer_cache&) = delete;
+      policy_answer_cache& operator=(const policy_answer_cache&) = delete;
+
+      bool lookup(const std::vector<std::string> &argv,
+		  std::string &answer) const;
+
+      void insert(const std::vector<std::string> &argv,
+		  const std::string &answer);
+
+    private:
+      struct _header;
+      struct _record_header;
+
+      static constexpr unsigned int _n_buckets_log2 = 16;
+
+      std::string _make_key(const std::vector<std::string> &argv) const;
+      static std::uint64_t _hash(const std::string &key) noexcept;
+
+      bool _find(std::uint64_t off, const std::uint64_t end_off,
+		 const std::string &key, std::string *answer) const;
+
+      const std::string _filename;
+      const std::string _epoch;
+      int _fd;
+      void *_map;
+      std::size_t _map_size;
+      std::uint64_t *_buckets;
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <dlfcn.h>
+#include "policy_plugin.hh"
+
+using namespace klp::ccp;
+
+policy_plugin::load_except::load_except(std::string &&what)
+  : _what(std::move(what))
+{}
+
+policy_plugin::load_except::~load_except() noexcept = default;
+
+const char* policy_plugin::load_except::what() const noexcept
+{
+  return _what.c_str();
+}
+
+
+policy_plugin::policy_plugin(const std::string &filename)
+  : _handle(nullptr), _ops(nullptr)
+{
+  _handle = dlopen(filename.c_str(), RTLD_NOW | RTLD_LOCAL);
+  if (!_handle)
+    throw load_except{dlerror()};
+
+  auto &&fail = [&](const std::string &what) {
+    dlclose(_handle);
+    return load_except{filename + ": " + what};
+  };
+
+  dlerror();
+  _ops = static_cast<const klp_ccp_pol_plugin_ops *>
+	   (dlsym(_handle, KLP_CCP_POL_PLUGIN_OPS_SYMBOL));
+  if (!_ops) {
+    throw fail(std::string("no symbol \"") + KLP_CCP_POL_PLUGIN_OPS_SYMBOL +
+	       "\"");
+  }
+
+  if (_ops->abi_version != KLP_CCP_POL_PLUGIN_ABI_VERSION) {
+    throw fail("unsupported ABI version " +
+	       std::to_string(_ops->abi_version));
+  }
+
+  if (!_ops->may_include_header || !_ops->can_externalize_fun ||
+      !_ops->shall_externalize_fun || !_ops->shall_externalize_obj ||
+      !_ops->modify_externalized_sym || !_ops->modify_patched_fun_sym ||
+      !_ops->rename_rewritten_fun) {
+    throw fail("mandatory operation missing");
+  }
+}
+
+policy_plugin::~policy_plugin() noexcept
+{
+  dlclose(_handle);
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef POLICY_PLUGIN_HH
+#define POLICY_PLUGIN_HH
+
+#include <stdexcept>
+#include <string>
+#include "klp_ccp_policy_plugin.h"
+
+namespace klp
+{
+  namespace ccp
+  {
+    // A loaded shared object implementing the policy plugin C ABI.
+    class policy_plugin
+    {
+    public:
+      class load_except : public std::exception
+      {
+      public:
+	virtual ~load_except() noexcept;
+
+	virtual const char* what() const noexcept override;
+
+      private:
+	friend class policy_plugin;
+
+	explicit load_except(std::string &&what);
+
+	const std::string _what;
+      };
+
+      explicit policy_plugin(const std::string &filename);
+
+      ~policy_plugin() noexcept;
+
+      policy_plugin(const policy_plugin&) = delete;
+      policy_plugin& operator=(const policy_plugin&) = delete;
+
+      const klp_ccp_pol_plugin_ops& get_ops() const noexcept
+      { return *_ops; }
+
+    private:
+      void *_handle;
+      const klp_ccp_pol_plugin_ops *_ops;
+    };
+  }
+}
+
+#endif
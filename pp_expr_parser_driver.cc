@@ -21,6 +21,7 @@
 #include "pp_except.hh"
 #include "parse_except.hh"
 #include "raw_pp_token.hh"
+#include "arena.hh"
 
 using namespace klp::ccp::yy;
 using namespace klp::ccp::ast;
@@ -107,6 +108,10 @@ pp_expr_parser_driver::~pp_expr_parser_driver() noexcept
 
 void pp_expr_parser_driver::parse()
 {
+  // Conditional inclusion expressions get parsed while an enclosing
+  // gnuc_parser_driver is active. Their short-lived ASTs don't
+  // belong to its arena.
+  arena::activation aa(nullptr);
   _parser.parse();
 }
 
@@ -130,16 +135,16 @@ pp_expr_parser_driver::lex(pp_expr_parser::semantic_type *value,
     } catch (const pp_except&) {
       throw;
     }
-  } while (tokens.back().is_type_any_of<pp_token::type::ws,
-					pp_token::type::empty,
-					pp_token::type::newline>() ||
-	   (tokens.back().is_id() &&
-	    tokens.back().get_value() == "__extension__"));
+  } while (tokens[last_index].is_type_any_of<pp_token::type::ws,
+					     pp_token::type::empty,
+					     pp_token::type::newline>() ||
+	   (tokens[last_index].is_id() &&
+	    tokens[last_index].get_value() == "__extension__"));
 
   loc->end = last_index + 1;
   loc->begin = last_index;
 
-  pp_token &tok = tokens.back();
+  pp_token &tok = tokens[last_index];
   if (tok.is_eof()) {
     return static_cast<pp_expr_parser::token_type>(0);
   }
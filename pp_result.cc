@@ -17,6 +17,8 @@
  */
 
 #include <cassert>
+#include <algorithm>
+#include <iterator>
 #include "pp_result.hh"
 #include "raw_pp_token.hh"
 #include "source_reader.hh"
@@ -226,42 +228,108 @@ pp_result::macro_undef::macro_undef(const std::string &name,
     _predefinition_pos(predefinition_pos)
 {}
 
-pp_result::used_macros::used_macros(_used_macros_type &&um)
-  : _used_macros(std::move(um))
+pp_result::used_macros::_node::_node(std::vector<const macro*> &&_macros,
+				     const std::size_t _hash)
+  : macros(std::move(_macros)), hash(_hash)
 {}
 
 void pp_result::used_macros::clear() noexcept
 {
-  _used_macros.clear();
+  _set.reset();
 }
 
 std::size_t pp_result::used_macros::count(const macro &m) const noexcept
 {
-  return _used_macros.count(std::ref(m));
+  if (!_set)
+    return 0;
+
+  return std::binary_search(_set->macros.cbegin(), _set->macros.cend(),
+			    &m, std::less<const macro*>());
 }
 
 pp_result::used_macros&
 pp_result::used_macros::operator+=(const used_macros &rhs)
 {
-  _used_macros.insert(rhs._used_macros.cbegin(),
-		      rhs._used_macros.cend());
+  if (!rhs._set || _set == rhs._set)
+    return *this;
+
+  if (!_set) {
+    _set = rhs._set;
+    return *this;
+  }
+
+  const std::vector<const macro*> &l = _set->macros;
+  const std::vector<const macro*> &r = rhs._set->macros;
+  const std::less<const macro*> less;
+  if (std::includes(l.cbegin(), l.cend(), r.cbegin(), r.cend(), less))
+    return *this;
+  if (std::includes(r.cbegin(), r.cend(), l.cbegin(), l.cend(), less)) {
+    _set = rhs._set;
+    return *this;
+  }
+
+  std::vector<const macro*> merged;
+  merged.reserve(l.size() + r.size());
+  std::set_union(l.cbegin(), l.cend(), r.cbegin(), r.cend(),
+		 std::back_inserter(merged), less);
+  _set = _intern(std::move(merged));
   return *this;
 }
 
 pp_result::used_macros&
 pp_result::used_macros::operator+=(const macro &rhs)
 {
-  _used_macros.insert(std::ref(rhs));
+  const std::less<const macro*> less;
+  if (!_set) {
+    _set = _intern(std::vector<const macro*>{&rhs});
+    return *this;
+  }
+
+  const std::vector<const macro*> &l = _set->macros;
+  const auto it = std::lower_bound(l.cbegin(), l.cend(), &rhs, less);
+  if (it != l.cend() && *it == &rhs)
+    return *this;
+
+  std::vector<const macro*> merged;
+  merged.reserve(l.size() + 1);
+  merged.insert(merged.end(), l.cbegin(), it);
+  merged.push_back(&rhs);
+  merged.insert(merged.end(), it, l.cend());
+  _set = _intern(std::move(merged));
   return *this;
 }
 
-bool pp_result::used_macros::_compare::
-operator()(const std::reference_wrapper<const macro> a,
-	   const std::reference_wrapper<const macro> b) const noexcept
+pp_result::used_macros::_nodes_type& pp_result::used_macros::_get_nodes()
 {
-  return &a.get() < &b.get();
+  // Never destroyed: used_macros instances with static storage
+  // duration might outlive it otherwise.
+  static _nodes_type * const nodes = new _nodes_type;
+  return *nodes;
 }
 
+std::shared_ptr<const pp_result::used_macros::_node>
+pp_result::used_macros::_intern(std::vector<const macro*> &&macros)
+{
+  std::size_t h = macros.size();
+  for (const macro *m : macros)
+    h ^= std::hash<const macro*>()(m) + 0x9e3779b9 + (h << 6) + (h >> 2);
+
+  _nodes_type &nodes = _get_nodes();
+  std::unique_ptr<_node> n(new _node(std::move(macros), h));
+  const auto it = nodes.find(n.get());
+  if (it != nodes.end()) {
+    // Nodes get removed from the table as soon as their last
+    // reference is gone, so this can't fail.
+    return (*it)->shared_from_this();
+  }
+
+  nodes.insert(n.get());
+  return std::shared_ptr<const _node>(n.release(),
+				      [](const _node *n) {
+					_get_nodes().erase(n);
+					delete n;
+				      });
+}
 
 pp_result::macro_nondef_constraint::
 macro_nondef_constraint(const std::string &id, bool func_like_allowed)
@@ -595,7 +663,9 @@ _skip_non_headers()
 
 pp_result::header_inclusion_node::
 header_inclusion_node(const std::string &filename)
-  : _filename(filename), _id(std::numeric_limits<unsigned long>::max())
+  : _filename(filename),
+    _offset_to_line_col_map(std::make_shared<offset_to_line_col_map>()),
+    _id(std::numeric_limits<unsigned long>::max())
 {}
 
 pp_result::header_inclusion_node::
@@ -603,7 +673,9 @@ header_inclusion_node(inclusion_node &parent,
 		      const raw_pp_token_index range_begin,
 		      const std::string &filename,
 		      const unsigned long id)
-  : inclusion_node(&parent, range_begin), _filename(filename), _id(id)
+  : inclusion_node(&parent, range_begin), _filename(filename),
+    _offset_to_line_col_map(std::make_shared<offset_to_line_col_map>()),
+    _id(id)
 {}
 
 pp_result::header_inclusion_node::~header_inclusion_node() noexcept = default;
@@ -616,20 +688,20 @@ pp_result::header_inclusion_node::get_containing_header() const noexcept
 
 void pp_result::header_inclusion_node::add_line(const std::streamoff length)
 {
-  _offset_to_line_col_map.add_line(length);
+  _offset_to_line_col_map->add_line(length);
 }
 
 std::pair<std::streamoff, std::streamoff>
 pp_result::header_inclusion_node::offset_to_line_col(const std::streamoff off)
   const noexcept
 {
-  return _offset_to_line_col_map.offset_to_line_col(off);
+  return _offset_to_line_col_map->offset_to_line_col(off);
 }
 
 std::unique_ptr<source_reader>
 pp_result::header_inclusion_node::create_source_reader() const
 {
-  return std::unique_ptr<source_reader>(new file_source_reader(_filename));
+  return std::unique_ptr<source_reader>(new mmap_source_reader(_filename));
 }
 
 unsigned long pp_result::header_inclusion_node::get_id() const noexcept
@@ -644,6 +716,21 @@ void pp_result::header_inclusion_node::_set_id(const unsigned long id) noexcept
   _id = id;
 }
 
+void pp_result::header_inclusion_node::
+_share_offset_to_line_col_map(const header_inclusion_node &from) noexcept
+{
+  assert(&from != this);
+  assert(this->_filename == from._filename);
+  _offset_to_line_col_map = from._offset_to_line_col_map;
+}
+
+void pp_result::header_inclusion_node::
+_share_offset_to_line_col_map(const std::shared_ptr<offset_to_line_col_map> &m)
+  noexcept
+{
+  _offset_to_line_col_map = m;
+}
+
 
 pp_result::header_inclusion_root::
 header_inclusion_root(const std::string &filename, const bool is_preinclude)
@@ -1641,3 +1728,20 @@ pp_result::_drop_pp_tokens_tail(const pp_tokens::size_type new_end)
 
   return std::make_pair(std::move(um), std::move(mnc));
 }
+
+void pp_result::_drop_pp_tokens(const macro_invocation * const keep_from)
+{
+  // Used by the preprocessor's streaming mode for discarding tokens
+  // already passed on to the consumer. The macro_invocations refer
+  // to these by index, so drop them as well, except for keep_from
+  // and any later ones, which might still be in progress.
+  auto it_keep = _macro_invocations.end();
+  if (keep_from) {
+    do {
+      assert(it_keep != _macro_invocations.begin());
+      --it_keep;
+    } while (it_keep->get() != keep_from);
+  }
+  _macro_invocations.erase(_macro_invocations.begin(), it_keep);
+  _pp_tokens.shrink(0);
+}
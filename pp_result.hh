@@ -23,6 +23,7 @@
 #include <memory>
 #include <utility>
 #include <set>
+#include <unordered_set>
 #include "raw_pp_tokens.hh"
 #include "raw_pp_tokens_range.hh"
 #include "pp_token.hh"
@@ -377,18 +378,19 @@ namespace klp
 	const noexcept;
 
 
+      // Sets of macros are hash-consed: each distinct set is stored
+      // only once, as a sorted array shared among all used_macros
+      // instances referring to it.
       class used_macros
       {
       private:
-	struct _compare
+	struct _node : public std::enable_shared_from_this<_node>
 	{
-	  bool operator()(const std::reference_wrapper<const macro> a,
-			  const std::reference_wrapper<const macro> b)
-	    const noexcept;
-	};
+	  _node(std::vector<const macro*> &&_macros, const std::size_t _hash);
 
-	typedef std::set<std::reference_wrapper<const macro>, _compare>
-		_used_macros_type;
+	  const std::vector<const macro*> macros;
+	  const std::size_t hash;
+	};
 
       public:
 	class const_iterator :
@@ -404,10 +406,10 @@ namespace klp
 	  }
 
 	  reference operator*() const noexcept
-	  { return _it->get(); }
+	  { return **_it; }
 
 	  pointer operator->() const noexcept
-	  { return &_it->get(); }
+	  { return *_it; }
 
 	  const_iterator& operator++() noexcept
 	  { ++_it; return *this; }
@@ -418,17 +420,17 @@ namespace klp
 	private:
 	  friend class used_macros;
 
-	  const_iterator(const _used_macros_type::const_iterator &it) noexcept
+	  const_iterator(const macro * const *it) noexcept
 	    : _it(it)
 	  {}
 
-	  _used_macros_type::const_iterator _it;
+	  const macro * const *_it;
 	};
 
 	used_macros() = default;
 
 	bool empty() const noexcept
-	{ return _used_macros.empty(); }
+	{ return !_set; }
 
 	void clear() noexcept;
 
@@ -439,15 +441,37 @@ namespace klp
 	used_macros& operator+=(const pp_result::macro &rhs);
 
 	const_iterator begin() const noexcept
-	{ return const_iterator{_used_macros.begin()}; }
+	{ return const_iterator{_set ? _set->macros.data() : nullptr}; }
 
 	const_iterator end() const noexcept
-	{ return const_iterator{_used_macros.end()}; }
+	{
+	  return const_iterator{_set ?
+				_set->macros.data() + _set->macros.size() :
+				nullptr};
+	}
 
       private:
-	used_macros(_used_macros_type &&um);
+	struct _node_hash
+	{
+	  std::size_t operator()(const _node *n) const noexcept
+	  { return n->hash; }
+	};
+
+	struct _node_equal
+	{
+	  bool operator()(const _node *a, const _node *b) const noexcept
+	  { return a->macros == b->macros; }
+	};
+
+	typedef std::unordered_set<const _node*, _node_hash, _node_equal>
+	  _nodes_type;
+
+	static _nodes_type& _get_nodes();
+
+	static std::shared_ptr<const _node>
+	_intern(std::vector<const macro*> &&macros);
 
-	_used_macros_type _used_macros;
+	std::shared_ptr<const _node> _set;
       };
 
       class macro_nondef_constraint
@@ -908,11 +932,18 @@ namespace klp
 
       private:
 	friend class pp_result;
+	friend class preprocessor;
+	friend class pp_tokenizer;
 
 	void _set_id(const unsigned long id) noexcept;
 
+	void _share_offset_to_line_col_map(const header_inclusion_node &from)
+	  noexcept;
+	void _share_offset_to_line_col_map
+		(const std::shared_ptr<offset_to_line_col_map> &m) noexcept;
+
 	const std::string _filename;
-	offset_to_line_col_map _offset_to_line_col_map;
+	std::shared_ptr<offset_to_line_col_map> _offset_to_line_col_map;
 	unsigned long _id;
       };
 
@@ -1479,6 +1510,8 @@ namespace klp
       std::pair<used_macros, macro_nondef_constraints>
       _drop_pp_tokens_tail(const pp_tokens::size_type new_end);
 
+      void _drop_pp_tokens(const macro_invocation * const keep_from);
+
       header_inclusion_roots _header_inclusion_roots;
       raw_pp_tokens _raw_tokens;
       pp_tokens _pp_tokens;
@@ -24,12 +24,13 @@
 
 using namespace klp::ccp;
 
-pp_token::pp_token(const type type, const std::string &value,
+pp_token::pp_token(const type type, const interned_string &value,
 		   const raw_pp_tokens_range &token_source)
   : _value(value), _token_source(token_source), _type(type)
 {}
 
-void pp_token::set_type_and_value(const type type, const std::string &value)
+void pp_token::set_type_and_value(const type type,
+				  const interned_string &value)
 {
   _type = type;
   _value = value;
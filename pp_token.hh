@@ -23,6 +23,7 @@
 #include <memory>
 #include "raw_pp_tokens_range.hh"
 #include "pp_result.hh"
+#include "interned_string.hh"
 
 namespace klp
 {
@@ -57,7 +58,7 @@ namespace klp
 	empty,
       };
 
-      pp_token(const type type, const std::string &value,
+      pp_token(const type type, const interned_string &value,
 	       const raw_pp_tokens_range &token_source);
 
       type get_type() const noexcept
@@ -66,11 +67,16 @@ namespace klp
       }
 
       const std::string& get_value() const noexcept
+      {
+	return _value.str();
+      }
+
+      const interned_string& get_interned_value() const noexcept
       {
 	return _value;
       }
 
-      void set_type_and_value(const type type, const std::string &value);
+      void set_type_and_value(const type type, const interned_string &value);
 
       const raw_pp_tokens_range& get_token_source() const noexcept
       { return _token_source; }
@@ -84,7 +90,7 @@ namespace klp
       bool is_punctuator(T &&s) const noexcept
       {
 	return (_type == pp_token::type::punctuator &&
-		_value == std::forward<T>(s));
+		_value.str() == std::forward<T>(s));
       }
 
       template <type... types>
@@ -133,7 +139,7 @@ namespace klp
 	}
       };
 
-      std::string _value;
+      interned_string _value;
       raw_pp_tokens_range _token_source;
       type _type;
     };
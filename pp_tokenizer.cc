@@ -19,6 +19,12 @@
 #include <cassert>
 #include <cerrno>
 #include <system_error>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 #include "pp_tokenizer.hh"
 #include "pp_except.hh"
 #include "source_reader.hh"
@@ -26,8 +32,195 @@
 using namespace klp::ccp;
 using namespace klp::ccp::impl;
 
+namespace
+{
+  // Character classes for bulk scanning runs of "uninteresting"
+  // characters in the tokenizer's inner loops. Each provides a scalar
+  // test as well as vectorized ones returning a byte mask of the
+  // members in the given input vector.
+#if defined(__SSE2__)
+  struct _vec128
+  {
+    typedef __m128i vec_type;
+    static constexpr std::size_t width = 16;
+
+    static vec_type load(const char *p) noexcept
+    { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+
+    static vec_type set1(const char c) noexcept
+    { return _mm_set1_epi8(c); }
+
+    static vec_type eq(const vec_type a, const vec_type b) noexcept
+    { return _mm_cmpeq_epi8(a, b); }
+
+    static vec_type gt(const vec_type a, const vec_type b) noexcept
+    { return _mm_cmpgt_epi8(a, b); }
+
+    static vec_type or_(const vec_type a, const vec_type b) noexcept
+    { return _mm_or_si128(a, b); }
+
+    static vec_type and_(const vec_type a, const vec_type b) noexcept
+    { return _mm_and_si128(a, b); }
+
+    static std::uint32_t movemask(const vec_type a) noexcept
+    { return static_cast<std::uint16_t>(_mm_movemask_epi8(a)); }
+
+    static constexpr std::uint32_t all_set = 0xffff;
+  };
+#endif
+
+#if defined(__AVX2__)
+  struct _vec256
+  {
+    typedef __m256i vec_type;
+    static constexpr std::size_t width = 32;
+
+    static vec_type load(const char *p) noexcept
+    { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+
+    static vec_type set1(const char c) noexcept
+    { return _mm256_set1_epi8(c); }
+
+    static vec_type eq(const vec_type a, const vec_type b) noexcept
+    { return _mm256_cmpeq_epi8(a, b); }
+
+    static vec_type gt(const vec_type a, const vec_type b) noexcept
+    { return _mm256_cmpgt_epi8(a, b); }
+
+    static vec_type or_(const vec_type a, const vec_type b) noexcept
+    { return _mm256_or_si256(a, b); }
+
+    static vec_type and_(const vec_type a, const vec_type b) noexcept
+    { return _mm256_and_si256(a, b); }
+
+    static std::uint32_t movemask(const vec_type a) noexcept
+    { return static_cast<std::uint32_t>(_mm256_movemask_epi8(a)); }
+
+    static constexpr std::uint32_t all_set = 0xffffffff;
+  };
+#endif
+
+  // [_a-zA-Z0-9]
+  struct _id_char_class
+  {
+    bool operator()(const char c) const noexcept
+    {
+      return (c == '_' || ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') ||
+	      ('0' <= c && c <= '9'));
+    }
+
+    template <typename vec>
+    typename vec::vec_type match(const typename vec::vec_type v) const noexcept
+    {
+      // Bytes >= 0x80 compare as negative and thus never match.
+      const typename vec::vec_type lower = vec::or_(v, vec::set1(0x20));
+      const typename vec::vec_type alpha =
+	vec::and_(vec::gt(lower, vec::set1('a' - 1)),
+		  vec::gt(vec::set1('z' + 1), lower));
+      const typename vec::vec_type digit =
+	vec::and_(vec::gt(v, vec::set1('0' - 1)),
+		  vec::gt(vec::set1('9' + 1), v));
+      return vec::or_(vec::or_(alpha, digit), vec::eq(v, vec::set1('_')));
+    }
+  };
+
+  // Horizontal whitespace, i.e. anything but newlines.
+  struct _hspace_class
+  {
+    bool operator()(const char c) const noexcept
+    {
+      return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+    }
+
+    template <typename vec>
+    typename vec::vec_type match(const typename vec::vec_type v) const noexcept
+    {
+      return vec::or_(vec::or_(vec::eq(v, vec::set1(' ')),
+			       vec::eq(v, vec::set1('\t'))),
+		      vec::or_(vec::eq(v, vec::set1('\v')),
+			       vec::eq(v, vec::set1('\f'))));
+    }
+  };
+
+  // Anything but the given four characters.
+  class _none_of_class
+  {
+  public:
+    _none_of_class(const char c0, const char c1, const char c2, const char c3)
+      noexcept
+      : _c0(c0), _c1(c1), _c2(c2), _c3(c3)
+    {}
+
+    bool operator()(const char c) const noexcept
+    {
+      return c != _c0 && c != _c1 && c != _c2 && c != _c3;
+    }
+
+    template <typename vec>
+    typename vec::vec_type match(const typename vec::vec_type v) const noexcept
+    {
+      // Inverted: the caller complements the resulting byte mask.
+      return vec::or_(vec::or_(vec::eq(v, vec::set1(_c0)),
+			       vec::eq(v, vec::set1(_c1))),
+		      vec::or_(vec::eq(v, vec::set1(_c2)),
+			       vec::eq(v, vec::set1(_c3))));
+    }
+
+  private:
+    const char _c0, _c1, _c2, _c3;
+  };
+
+  // Whether a character class' vectorized match() yields the
+  // complement.
+  template <typename char_class_type>
+  struct _match_inverted
+  {
+    static constexpr bool value = false;
+  };
+
+  template <>
+  struct _match_inverted<_none_of_class>
+  {
+    static constexpr bool value = true;
+  };
+
+#if defined(__SSE2__)
+  template <typename vec, typename char_class_type>
+  const char* _scan_run_vec(const char *it, const char * const end,
+				   const char_class_type &cc) noexcept
+  {
+    while (static_cast<std::size_t>(end - it) >= vec::width) {
+      std::uint32_t mask = vec::movemask(cc.template match<vec>(vec::load(it)));
+      if (!_match_inverted<char_class_type>::value)
+	mask ^= vec::all_set;
+      if (mask)
+	return it + __builtin_ctz(mask);
+      it += vec::width;
+    }
+    return it;
+  }
+#endif
+
+  // Returns the end of the longest prefix of [it, end) consisting
+  // only of members of the given character class.
+  template <typename char_class_type>
+  const char* _scan_run(const char *it, const char * const end,
+			       const char_class_type &cc) noexcept
+  {
+#if defined(__AVX2__)
+    it = _scan_run_vec<_vec256>(it, end, cc);
+#endif
+#if defined(__SSE2__)
+    it = _scan_run_vec<_vec128>(it, end, cc);
+#endif
+    while (it != end && cc(*it))
+      ++it;
+    return it;
+  }
+}
+
 _pp_tokenizer::_pp_tokenizer()
-  : _buf(), _buf_it(_buf.cbegin()),
+  : _buf_it(nullptr), _buf_end(nullptr),
     _line_length(0), _cur_loc(0), _next_loc(0), _next_next_loc(0),
     _expect_qh_str(expect_qh_str::newline),
     _pending(0), _cur(-1), _next(-1), _next_next(-1)
@@ -57,14 +250,15 @@ char _pp_tokenizer::_read_next_char_raw()
     return c;
   }
 
-  if (_buf_it == _buf.cend()) {
-    _buf = this->read_raw();
-    _buf_it = _buf.cbegin();
-    if (_buf.empty())
+  if (_buf_it == _buf_end) {
+    const chunk_type next_chunk = this->read_raw();
+    _buf_it = next_chunk.begin;
+    _buf_end = next_chunk.end;
+    if (_buf_it == _buf_end)
       return 0;
   }
 
-  const char c = static_cast<char>(*_buf_it++);
+  const char c = *_buf_it++;
   ++_line_length;
 
   if (c == '\n') {
@@ -116,6 +310,46 @@ void _pp_tokenizer::_skip_next_char()
   _advance_to_next_char();
 }
 
+template <typename char_class_type>
+std::size_t _pp_tokenizer::_consume_run(const char_class_type &cc,
+					std::string * const value)
+{
+  // Fast path for skipping over a run of characters from the given
+  // class directly in the buffer. Only applicable if the
+  // lookahead characters are all members themselves and there's no
+  // line continuation in between. Any backslash or newline in
+  // the buffer terminates the run, because none of the character
+  // classes includes these, so the slow path in _read_next_char() will
+  // take care of them.
+  if (_pending ||
+      _next_loc != _cur_loc + 1 || _next_next_loc != _next_loc + 1 ||
+      !cc(_cur) || !cc(_next) || !cc(_next_next)) {
+    return 0;
+  }
+
+  const std::size_t n = _scan_run(_buf_it, _buf_end, cc) - _buf_it;
+  if (n < 3)
+    return 0;
+
+  if (value) {
+    value->push_back(_cur);
+    value->push_back(_next);
+    value->push_back(_next_next);
+    value->append(_buf_it, n - 3);
+  }
+
+  _cur = _buf_it[n - 3];
+  _next = _buf_it[n - 2];
+  _next_next = _buf_it[n - 1];
+  _cur_loc += n;
+  _next_loc += n;
+  _next_next_loc += n;
+  _buf_it += n;
+  _line_length += n;
+
+  return n;
+}
+
 raw_pp_token _pp_tokenizer::_tokenize_string(const char delim,
 					     const bool delim_escapable,
 					     const pp_token::type tok_type)
@@ -124,6 +358,11 @@ raw_pp_token _pp_tokenizer::_tokenize_string(const char delim,
   bool in_escape = false;
 
   while(_cur) {
+    if (!in_escape &&
+	_consume_run(_none_of_class(delim, '\\', '\n', '\0'), &value)) {
+      continue;
+    }
+
     if (_cur != delim || (delim_escapable && in_escape)) {
       if (in_escape) {
 	in_escape = false;
@@ -312,6 +551,8 @@ raw_pp_token _pp_tokenizer::_tokenize_id()
     case 'a' ... 'z':
     case 'A' ... 'Z':
     case '0' ... '9':
+      if (_consume_run(_id_char_class(), &value))
+	break;
       value.push_back(_cur);
       _advance_to_next_char();
       break;
@@ -336,6 +577,13 @@ std::size_t _pp_tokenizer::_skip_c_comment(const std::size_t n_trailing_spaces)
       _skip_next_char();
       return n_chars_in_last_line + 2;
     } else {
+      const std::size_t n =
+	_consume_run(_none_of_class('*', '\\', '\n', '\0'), nullptr);
+      if (n) {
+	n_chars_in_last_line += n;
+	continue;
+      }
+
       if (_cur != '\n')
 	++n_chars_in_last_line;
       else
@@ -352,6 +600,8 @@ void _pp_tokenizer::_skip_cpp_comment()
   assert(_cur == '/' && _next == '/');
   _skip_next_char();
   while(_cur != '\n') {
+    if (_consume_run(_none_of_class('\\', '\n', '\0', '\n'), nullptr))
+      continue;
     _advance_to_next_char();
 
     if (!_cur)
@@ -417,6 +667,13 @@ raw_pp_token _pp_tokenizer::_tokenize_ws()
     case '\t':
     case '\v':
     case '\f':
+      {
+	const std::size_t n = _consume_run(_hspace_class(), nullptr);
+	if (n) {
+	  n_spaces += n;
+	  break;
+	}
+      }
       ++n_spaces;
       _advance_to_next_char();
       break;
@@ -611,8 +868,22 @@ raw_pp_token _pp_tokenizer::read_next_token()
 
 
 pp_tokenizer::pp_tokenizer(pp_result::header_inclusion_node &file)
-  : _file(file), _sr(_file.create_source_reader())
+  : _file(file), _replay_pos(0)
 {
+  // Root files are read only once, don't bother caching them.
+  if (_file.get_parent()) {
+    const _tokens_cache_type &cache = _get_tokens_cache();
+    const auto it = cache.find(_file.get_filename());
+    if (it != cache.end()) {
+      _replayed = it->second;
+      _file._share_offset_to_line_col_map(_replayed->line_map);
+      return;
+    }
+
+    _recorded.reset(new _cached_tokens{});
+  }
+
+  _sr = _file.create_source_reader();
   init_state();
 }
 
@@ -620,10 +891,29 @@ pp_tokenizer::~pp_tokenizer() noexcept = default;
 
 raw_pp_token pp_tokenizer::read_next_token()
 {
-  return impl::_pp_tokenizer::read_next_token();
+  if (_replayed) {
+    const raw_pp_token &tok = _replayed->toks[_replay_pos];
+    if (!tok.is_eof())
+      ++_replay_pos;
+    return tok;
+  }
+
+  raw_pp_token tok = impl::_pp_tokenizer::read_next_token();
+  if (_recorded) {
+    _recorded->toks.push_back(tok);
+    if (tok.is_eof()) {
+      _recorded->line_map = _file._offset_to_line_col_map;
+      _get_tokens_cache().insert
+	(std::make_pair(_file.get_filename(),
+			std::shared_ptr<const _cached_tokens>
+				{std::move(_recorded)}));
+    }
+  }
+
+  return tok;
 }
 
-_pp_tokenizer::buffer_type pp_tokenizer::read_raw()
+_pp_tokenizer::chunk_type pp_tokenizer::read_raw()
 {
   return _sr->read();
 }
@@ -636,6 +926,8 @@ void pp_tokenizer::add_line(const std::streamoff length)
 void pp_tokenizer::report_warning(const std::string &msg,
 				  const range_in_file::loc_type loc)
 {
+  // Replaying the tokens would lose the warning, don't cache them.
+  _recorded.reset();
   _remarks.add(code_remark(code_remark::severity::warning,
 			   msg, _file, range_in_file{loc}));
 }
@@ -649,12 +941,18 @@ pp_except pp_tokenizer::report_fatal(const std::string &msg,
   return pp_except{remark};
 }
 
+pp_tokenizer::_tokens_cache_type& pp_tokenizer::_get_tokens_cache()
+{
+  static _tokens_cache_type cache;
+  return cache;
+}
+
 
 pp_string_tokenizer::
 pp_string_tokenizer(const std::string &s,
 		    const report_warning_type &report_warning,
 		    const report_fatal_type &report_fatal)
-  : _buf(s.begin(), s.end()),
+  : _buf(s.begin(), s.end()), _buf_consumed(false),
     _report_warning(report_warning), _report_fatal(report_fatal)
 {
   init_state();
@@ -691,9 +989,13 @@ raw_pp_tokens pp_string_tokenizer::tokenize_builtin(const std::string &s)
   return result;
 }
 
-_pp_tokenizer::buffer_type pp_string_tokenizer::read_raw()
+_pp_tokenizer::chunk_type pp_string_tokenizer::read_raw()
 {
-  return std::move(_buf);
+  if (_buf_consumed)
+    return chunk_type{};
+
+  _buf_consumed = true;
+  return chunk_type{_buf.data(), _buf.data() + _buf.size()};
 }
 
 void pp_string_tokenizer::add_line(const std::streamoff)
@@ -21,16 +21,19 @@
 
 #include <string>
 #include <vector>
+#include <map>
+#include <memory>
 #include "code_remarks.hh"
 #include "raw_pp_token.hh"
+#include "raw_pp_tokens.hh"
 #include "pp_result.hh"
+#include "source_reader.hh"
 
 namespace klp
 {
   namespace ccp
   {
     class pp_except;
-    class source_reader;
 
     namespace impl
     {
@@ -38,6 +41,7 @@ namespace klp
       {
       protected:
 	typedef std::vector<char> buffer_type;
+	typedef source_reader::chunk chunk_type;
 
 	_pp_tokenizer();
 
@@ -48,7 +52,7 @@ namespace klp
 	raw_pp_token read_next_token();
 
       private:
-	virtual buffer_type read_raw() = 0;
+	virtual chunk_type read_raw() = 0;
 
 	virtual void add_line(const std::streamoff length) = 0;
 
@@ -63,6 +67,10 @@ namespace klp
 	void _advance_to_next_char();
 	void _skip_next_char();
 
+	template <typename char_class_type>
+	std::size_t _consume_run(const char_class_type &cc,
+				 std::string * const value);
+
 	raw_pp_token _tokenize_string(const char delim,
 				      const bool delim_escapable,
 				      const pp_token::type tok_type);
@@ -73,8 +81,8 @@ namespace klp
 	void _skip_cpp_comment();
 	raw_pp_token _tokenize_ws();
 
-	buffer_type _buf;
-	buffer_type::const_iterator _buf_it;
+	const char *_buf_it;
+	const char *_buf_end;
 
 	range_in_file::loc_type _line_length;
 	range_in_file::loc_type _cur_loc;
@@ -116,7 +124,7 @@ namespace klp
       { return _file; }
 
     private:
-      virtual buffer_type read_raw() override;
+      virtual chunk_type read_raw() override;
 
       virtual void add_line(const std::streamoff length) override;
 
@@ -126,9 +134,27 @@ namespace klp
 				     const range_in_file::loc_type loc)
 	override;
 
+      // Headers get tokenized only once per process. The resulting
+      // raw_pp_token sequence is recorded and replayed for subsequent
+      // inclusions.
+      struct _cached_tokens
+      {
+	raw_pp_tokens toks;
+	std::shared_ptr<offset_to_line_col_map> line_map;
+      };
+
+      typedef std::map<std::string, std::shared_ptr<const _cached_tokens>>
+	_tokens_cache_type;
+
+      static _tokens_cache_type& _get_tokens_cache();
+
       pp_result::header_inclusion_node &_file;
       std::unique_ptr<source_reader> _sr;
       code_remarks _remarks;
+
+      std::shared_ptr<const _cached_tokens> _replayed;
+      raw_pp_tokens::size_type _replay_pos;
+      std::unique_ptr<_cached_tokens> _recorded;
     };
 
 
@@ -149,7 +175,7 @@ namespace klp
       static raw_pp_tokens tokenize_builtin(const std::string &s);
 
     private:
-      virtual buffer_type read_raw() override;
+      virtual chunk_type read_raw() override;
 
       virtual void add_line(const std::streamoff) override;
 
@@ -160,6 +186,7 @@ namespace klp
 	override;
 
       buffer_type _buf;
+      bool _buf_consumed;
       report_warning_type _report_warning;
       report_fatal_type _report_fatal;
     };
@@ -16,6 +16,7 @@
  * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
 #include "preprocessor.hh"
@@ -47,7 +48,7 @@ preprocessor::preprocessor(const header_resolver &header_resolver,
 			    "__COUNTER__" }) {
     const pp_result::macro &m =
       _pp_result->_add_macro(name, pp_result::macro::builtin_special_tag{});
-    _macros.insert(std::make_pair(m.get_name(), std::ref(m)));
+    _macros.insert(m);
   }
 }
 
@@ -271,6 +272,35 @@ pp_token_index preprocessor::read_next_token()
   return _emit_pp_token(*_pp_result, std::move(prev_tok));
 }
 
+void preprocessor::
+stream_tokens(const std::function<void(const pp_token&)> &consumer)
+{
+  while (true) {
+    const pp_token &tok = _pp_result->get_pp_tokens()[read_next_token()];
+    consumer(tok);
+    if (tok.is_eof())
+      return;
+
+    // Don't drop anything while in the middle of some macro
+    // expansion. Otherwise, only lookahead tokens from
+    // ::_pending_tokens can refer to some macro_invocation, and this
+    // must be retained.
+    if (_cur_macro_invocation ||
+	!_root_expansion_state.macro_instances.empty() ||
+	!_root_expansion_state.pending_tokens.empty()) {
+      continue;
+    }
+
+    const pp_result::macro_invocation *keep_from = nullptr;
+    if (!_pending_tokens.empty()) {
+      keep_from = _pending_tokens.front().get_macro_invocation();
+      if (!keep_from)
+	keep_from = _pending_tokens.back().get_macro_invocation();
+    }
+    _pp_result->_drop_pp_tokens(keep_from);
+  }
+}
+
 void preprocessor::register_builtin_macro(const std::string &name,
 					  const std::string &repl)
 {
@@ -290,7 +320,7 @@ void preprocessor::register_builtin_macro(const std::string &name,
     _pp_result->_add_macro(name, false, false, std::vector<std::string>{},
 			   pp_string_tokenizer::tokenize_builtin(repl),
 			   pp_result::macro::builtin_tag{});
-  if (!_macros.insert(std::make_pair(m.get_name(), std::ref(m))).second)
+  if (!_macros.insert(m))
     assert(0);
 }
 
@@ -321,7 +351,7 @@ register_builtin_macro(const std::string &name,
     _pp_result->_add_macro(name, true, variadic, std::move(_arg_list),
 			   std::move(normalized_repl),
 			   pp_result::macro::builtin_tag{});
-  if (!_macros.insert(std::make_pair(m.get_name(), std::ref(m))).second)
+  if (!_macros.insert(m))
     assert(0);
 }
 
@@ -403,12 +433,12 @@ void preprocessor::register_predefined_macro
 			   std::move(normalized_repl),
 			   pp_result::macro::predefined_user_tag{});
 
-  const auto it_existing = _macros.find(name);
-  if (it_existing != _macros.end() && it_existing->second.get() != m) {
+  const pp_result::macro * const existing = _macros.find(name);
+  if (existing && *existing != m) {
     throw report_fatal("macro redefined in an incompatible way");
   }
 
-  _macros.insert(std::make_pair(m.get_name(), std::ref(m)));
+  _macros.insert(m);
 }
 
 void preprocessor::register_predefined_macro_undef
@@ -453,7 +483,7 @@ void preprocessor::register_predefined_macro_undef
 
   _pp_result->_add_macro_undef(it_name->get_value(),
 			       pp_result::macro_undef::predefined_user_tag{});
-  _macros.erase(it_name->get_value());
+  _macros.erase(it_name->get_interned_value());
 }
 
 template<typename T>
@@ -467,7 +497,8 @@ void preprocessor::_grab_remarks_from(T &from)
 pp_token_index preprocessor::_emit_pp_token(pp_result &r, _pp_token &&tok)
 {
   r._append_token
-    (pp_token{tok.get_type(), tok.get_value(), tok.get_token_source()});
+    (pp_token{tok.get_type(), tok.get_interned_value(),
+	      tok.get_token_source()});
 
   const pp_token_index tok_index = r._get_last_pp_index();
   // Amend the macro_invocation's map of passed through raw macro
@@ -525,7 +556,7 @@ preprocessor::_pp_token preprocessor::_read_next_plain_token()
 
     const raw_pp_token_index raw_token_index =
       _pp_result->_get_last_raw_index();
-    return _pp_token{raw_tok.get_type(), raw_tok.get_value(),
+    return _pp_token{raw_tok.get_type(), raw_tok.get_interned_value(),
 		     raw_pp_tokens_range{raw_token_index},
 		     raw_token_index};
   } catch (const pp_except&) {
@@ -552,19 +583,20 @@ void preprocessor::_handle_eof_from_tokenizer(raw_pp_token &&eof_tok)
     throw pp_except(remark);
   }
 
-  _tokenizers.pop();
   const raw_pp_token_index cur_raw_pos =
     (!_pp_result->get_raw_tokens().empty() ?
      _pp_result->_get_last_raw_index() + 1 :
      0);
   _inclusions.top().get()._set_range_end(cur_raw_pos);
+  _register_header_guard(_tokenizers.top().get_header_inclusion_node());
+  _tokenizers.pop();
   _inclusions.pop();
 
   if (_tokenizers.empty()) {
     if (++_cur_header_inclusion_root ==
 	_pp_result->get_header_inclusion_roots().end()) {
       const raw_pp_token_index eof_index = _pp_result->get_raw_tokens().size();
-      _eof_tok = _pp_token{eof_tok.get_type(), eof_tok.get_value(),
+      _eof_tok = _pp_token{eof_tok.get_type(), eof_tok.get_interned_value(),
 			   raw_pp_tokens_range{eof_index, eof_index}};
       return;
     }
@@ -799,9 +831,10 @@ void preprocessor::_handle_pp_directive()
     _push_cond_incl(raw_begin);
     _cond_incl_states.top().directive_ranges.emplace_back(raw_begin, raw_end);
 
-    auto it_m = _macros.find(it_tok->get_value());
-    if (it_m != _macros.end()) {
-      _cond_incl_states.top().um += it_m->second;
+    const pp_result::macro * const m =
+      _macros.find(it_tok->get_interned_value());
+    if (m) {
+      _cond_incl_states.top().um += *m;
       _enter_cond_incl();
     } else {
       _cond_incl_states.top().mnc +=
@@ -829,9 +862,10 @@ void preprocessor::_handle_pp_directive()
     _push_cond_incl(raw_begin);
     _cond_incl_states.top().directive_ranges.emplace_back(raw_begin, raw_end);
 
-    auto it_m = _macros.find(it_tok->get_value());
-    if (it_m != _macros.end()) {
-      _cond_incl_states.top().um += it_m->second;
+    const pp_result::macro * const m =
+      _macros.find(it_tok->get_interned_value());
+    if (m) {
+      _cond_incl_states.top().um += *m;
     } else {
       _cond_incl_states.top().mnc +=
 	pp_result::macro_nondef_constraint{it_tok->get_value()};
@@ -905,8 +939,8 @@ void preprocessor::_handle_pp_directive()
     const pp_result::macro &m =
       _handle_macro_definition(raw_pp_tokens_range{raw_begin, raw_end});
 
-    auto it_existing = _macros.find(m.get_name());
-    if (it_existing != _macros.end() && it_existing->second.get() != m) {
+    const pp_result::macro * const existing = _macros.find(m.get_name());
+    if (existing && *existing != m) {
       code_remark remark(code_remark::severity::fatal,
 		"macro redefined in an incompatible way",
 		_raw_pp_tokens_range_to_source(m.get_directive_range()),
@@ -915,7 +949,7 @@ void preprocessor::_handle_pp_directive()
       throw pp_except(remark);
     }
 
-    _macros.insert(std::make_pair(m.get_name(), std::ref(m)));
+    _macros.insert(m);
   } else if (it_tok->get_value() == "undef") {
     ++it_tok;
     if (it_tok->is_ws())
@@ -944,14 +978,21 @@ void preprocessor::_handle_pp_directive()
     _pp_result->_add_macro_undef(it_tok_id->get_value(),
 				 raw_pp_tokens_range{raw_begin, raw_end});
 
-    auto it_m = _macros.find(it_tok_id->get_value());
-    if (it_m != _macros.end()) {
-      _macros.erase(it_m);
-    }
+    _macros.erase(it_tok_id->get_interned_value());
 
   } else if (it_tok->get_value() == "include") {
     _handle_include(raw_pp_tokens_range{raw_begin, raw_end});
 
+  } else if (it_tok->get_value() == "pragma") {
+    ++it_tok;
+    if (it_tok->is_ws())
+      ++it_tok;
+
+    if (it_tok->is_id() && it_tok->get_value() == "once") {
+      _once_only_headers.insert
+	(_tokenizers.top().get_header_inclusion_node().get_filename());
+    }
+
   }
 }
 
@@ -1007,21 +1048,22 @@ preprocessor::_expand(_expansion_state &state,
 
   // Deal with possible macro invocation
   if (tok.is_id()) {
-    auto m = _macros.find(tok.get_value());
-    if (m != _macros.end() && !tok.expansion_history().count(m->second)) {
-      if (!m->second.get().is_func_like()) {
+    const pp_result::macro * const m =
+      _macros.find(tok.get_interned_value());
+    if (m && !tok.expansion_history().count(*m)) {
+      if (!m->is_func_like()) {
 	const raw_pp_tokens_range &tok_range = tok.get_token_source();
 	if (!_cur_macro_invocation) {
 	  assert(_root_expansion_state.macro_instances.empty());
 	  assert(state_is_root);
 	  assert(tok_range.begin + 1 == tok_range.end);
 	  _cur_macro_invocation =
-	    &_pp_result->_add_macro_invocation(m->second, tok_range);
+	    &_pp_result->_add_macro_invocation(*m, tok_range);
 	} else {
-	  _cur_macro_invocation->_used_macros += m->second;
+	  _cur_macro_invocation->_used_macros += *m;
 	}
 	state.macro_instances.push_back(
-		_handle_object_macro_invocation(m->second, std::move(tok)));
+		_handle_object_macro_invocation(*m, std::move(tok)));
 	goto read_next;
       } else {
 	// It can happen that the tail result of some previous macro
@@ -1056,14 +1098,14 @@ preprocessor::_expand(_expansion_state &state,
 	    const raw_pp_tokens_range &tok_range = tok.get_token_source();
 	    assert(tok_range.begin + 1 == tok_range.end);
 	    _cur_macro_invocation =
-	      &_pp_result->_add_macro_invocation(m->second, tok_range);
+	      &_pp_result->_add_macro_invocation(*m, tok_range);
 	  } else {
-	    _cur_macro_invocation->_used_macros += m->second;
+	    _cur_macro_invocation->_used_macros += *m;
 	  }
 
 	  keep_cur_macro_invocation = true;
 	  state.macro_instances.push_back(_handle_func_macro_invocation(
-						m->second,
+						*m,
 						tok.get_token_source().begin,
 						read_tok,
 						&raw_tokens_read));
@@ -1084,7 +1126,7 @@ preprocessor::_expand(_expansion_state &state,
 	state.pending_tokens.push(std::move(next_tok));
       }
 
-    } else if (m == _macros.end() && _cur_macro_invocation) {
+    } else if (!m && _cur_macro_invocation) {
       // The current token came from some macro expansion, but doesn't
       // resolve to a macro definition itself. Register a
       // macro_nondef_constraint instance for the
@@ -1173,12 +1215,12 @@ preprocessor::_expand(_expansion_state &state,
 	  pp_result::macro_nondef_constraint{"defined"};
       }
 
-      const std::string &id = std::get<0>(arg)[0].get_value();
+      const interned_string &id = std::get<0>(arg)[0].get_interned_value();
       bool is_defined = false;
-      auto it_m = _macros.find(id);
-      if (it_m != _macros.end()) {
+      const pp_result::macro * const m = _macros.find(id);
+      if (m) {
 	assert(!_cond_incl_states.empty());
-	_cond_incl_states.top().um += it_m->second;
+	_cond_incl_states.top().um += *m;
 	is_defined = true;
       } else {
 	assert(!_cond_incl_states.empty());
@@ -1198,7 +1240,7 @@ preprocessor::_expand(_expansion_state &state,
 
 
 preprocessor::_pp_token::
-_pp_token(const pp_token::type type, const std::string &value,
+_pp_token(const pp_token::type type, const interned_string &value,
 	  const raw_pp_tokens_range &token_source,
 	  const pp_result::used_macros &eh,
 	  const raw_pp_token_index passed_through_raw_token)
@@ -1208,7 +1250,7 @@ _pp_token(const pp_token::type type, const std::string &value,
 {}
 
 preprocessor::_pp_token::
-_pp_token(const pp_token::type type, const std::string &value,
+_pp_token(const pp_token::type type, const interned_string &value,
 	  const raw_pp_tokens_range &token_source,
 	  const raw_pp_token_index passed_through_raw_token)
   : _value(value), _token_source(token_source), _macro_invocation(nullptr),
@@ -1216,7 +1258,7 @@ _pp_token(const pp_token::type type, const std::string &value,
 {}
 
 void preprocessor::_pp_token::set_type_and_value(const pp_token::type type,
-						 const std::string &value)
+						 const interned_string &value)
 {
   _type = type;
   _value = value;
@@ -1265,7 +1307,7 @@ void preprocessor::_pp_token::concat(const _pp_token &tok,
   }
 
   if (_type == pp_token::type::id && tok._type == pp_token::type::pp_number) {
-    if (!std::all_of(tok._value.cbegin(), tok._value.cend(),
+    if (!std::all_of(tok._value.str().cbegin(), tok._value.str().cend(),
 		     [](const char c) {
 		       return (c == '_' || ('a' <= c && c <= 'z') ||
 			       ('A' <= c && c <= 'Z') ||
@@ -1273,22 +1315,22 @@ void preprocessor::_pp_token::concat(const _pp_token &tok,
 		     })) {
       code_remark remark
 	(code_remark::severity::fatal,
-	 "can't concatenate " + _value + " and " + tok._value,
+	 "can't concatenate " + _value.str() + " and " + tok._value.str(),
 	 p._pp_token_to_source(tok), p._pp_token_to_range_in_file(tok));
       remarks.add(remark);
       throw pp_except(remark);
     }
 
-    _value += tok._value;
+    _value = _value.str() + tok._value.str();
     return;
   } else if (_type == pp_token::type::pp_number &&
 	     tok._type == pp_token::type::id) {
-    _value += tok._value;
+    _value = _value.str() + tok._value.str();
     return;
   } else if (_type == pp_token::type::pp_number &&
 	     tok._type == pp_token::type::punctuator &&
      (tok._value == "-" || tok._value == "+")) {
-    _value += tok._value;
+    _value = _value.str() + tok._value.str();
     return;
   }
 
@@ -1308,14 +1350,15 @@ void preprocessor::_pp_token::concat(const _pp_token &tok,
     throw pp_except(remark);
   } else if (_type == pp_token::type::non_ws_char) {
     code_remark remark(code_remark::severity::fatal,
-		       "can't concatenate " + _value + " and " + tok._value,
+		       ("can't concatenate " + _value.str() + " and " +
+			tok._value.str()),
 		       p._pp_token_to_source(tok),
 		       p._pp_token_to_range_in_file(tok));
     remarks.add(remark);
     throw pp_except(remark);
   }
 
-  _value += tok._value;
+  _value = _value.str() + tok._value.str();
 
   if (_type == pp_token::type::punctuator) {
     if (_value != "->" && _value != "++" && _value != "--" && _value != "<<" &&
@@ -1328,7 +1371,7 @@ void preprocessor::_pp_token::concat(const _pp_token &tok,
 	_value != "%:%:") {
       code_remark remark
 	(code_remark::severity::fatal,
-	 "can't concatenate " + _value + " and " + tok._value,
+	 "can't concatenate " + _value.str() + " and " + tok._value.str(),
 	 p._pp_token_to_source(tok), p._pp_token_to_range_in_file(tok));
       remarks.add(remark);
       throw pp_except(remark);
@@ -1634,7 +1677,7 @@ void preprocessor::_handle_include(const raw_pp_tokens_range &directive_range)
 			 raw_pp_tokens_range{tok_index, tok_index});
       }
 
-      _pp_token tok{it_raw_tok->get_type(), it_raw_tok->get_value(),
+      _pp_token tok{it_raw_tok->get_type(), it_raw_tok->get_interned_value(),
 		    raw_pp_tokens_range{tok_index}};
       ++it_raw_tok;
       return tok;
@@ -1752,10 +1795,132 @@ void preprocessor::_handle_include(const raw_pp_tokens_range &directive_range)
 						    std::move(um),
 						    std::move(mnc),
 						    *_pp_result);
+
+  // Don't bother to read headers which have been marked with
+  // #pragma once or which are guarded by some macro known to be
+  // defined at this point again.
+  if (_once_only_headers.count(resolved)) {
+    new_header_inclusion_node._set_range_end(directive_range.end);
+    return;
+  }
+
+  const auto it_guard = _header_guards.find(resolved);
+  if (it_guard != _header_guards.end()) {
+    const pp_result::macro * const guard_macro =
+      _macros.find(it_guard->second.macro_name);
+    if (guard_macro) {
+      _inclusions.emplace(std::ref(new_header_inclusion_node));
+      _skip_guarded_header(new_header_inclusion_node, it_guard->second,
+			   *guard_macro);
+      _inclusions.pop();
+      return;
+    }
+  }
+
   _tokenizers.emplace(new_header_inclusion_node);
   _inclusions.emplace(std::ref(new_header_inclusion_node));
 }
 
+void preprocessor::
+_register_header_guard(const pp_result::header_inclusion_node &h)
+{
+  // Check whether the header just finished follows the classic
+  //   #ifndef X
+  //   ...
+  //   #endif
+  // pattern with nothing but whitespace around it.
+  if (_header_guards.count(h.get_filename()) || h._children.empty())
+    return;
+
+  const pp_result::inclusion_node::_child &first_child = h._children.front();
+  if (first_child.k != pp_result::inclusion_node::_child::kind::conditional)
+    return;
+
+  const pp_result::conditional_inclusion_node &c = *first_child.c;
+  if (c.nbranches() != 1)
+    return;
+
+  const raw_pp_tokens &raw_toks = _pp_result->get_raw_tokens();
+  auto &&any_nontrivial_token_between =
+    [&](const raw_pp_token_index b, const raw_pp_token_index e) {
+      return std::any_of(raw_toks.begin() + b, raw_toks.begin() + e,
+			 [](const raw_pp_token &tok) {
+			   return !(tok.is_ws() || tok.is_newline() ||
+				    tok.is_eof());
+			 });
+    };
+
+  if (any_nontrivial_token_between(h.get_range().begin, c.get_range().begin) ||
+      any_nontrivial_token_between(c.get_range().end, h.get_range().end)) {
+    return;
+  }
+
+  auto it_tok = raw_toks.begin() + c.get_branch_directive_range(0).begin;
+  assert(it_tok->is_punctuator("#"));
+  ++it_tok;
+  if (it_tok->is_ws())
+    ++it_tok;
+  assert(it_tok->is_id());
+  if (it_tok->get_value() != "ifndef")
+    return;
+  ++it_tok;
+  if (it_tok->is_ws())
+    ++it_tok;
+  assert(it_tok->is_id());
+
+  _header_guards.insert(std::make_pair(h.get_filename(),
+				       _header_guard{c, it_tok->get_value()}));
+}
+
+void preprocessor::
+_skip_guarded_header(pp_result::header_inclusion_child &h,
+		     const _header_guard &guard,
+		     const pp_result::macro &guard_macro)
+{
+  // The header's contents would be skipped over anyway. Rather than
+  // reading and tokenizing it again, replay the raw tokens up to and
+  // including the #ifndef directive as well as those from the
+  // #endif onwards from the header's first inclusion and record the
+  // non-taken conditional inclusion as _handle_pp_directive() would
+  // have done.
+  const pp_result::conditional_inclusion_node &c = guard.cond_incl.get();
+  const raw_pp_tokens_range &first_range = c.get_containing_header().get_range();
+  const raw_pp_tokens_range &ifndef_range = c.get_branch_directive_range(0);
+  const raw_pp_tokens_range &endif_range = c.get_branch_directive_range(1);
+
+  auto &&replay =
+    [&](const raw_pp_tokens_range &r) {
+      const raw_pp_token_index begin = _pp_result->get_raw_tokens().size();
+      for (raw_pp_token_index i = r.begin; i != r.end; ++i) {
+	// Copy the token first: appending might reallocate the
+	// container.
+	raw_pp_token tok = _pp_result->get_raw_tokens()[i];
+	_pp_result->_append_token(std::move(tok));
+      }
+      return raw_pp_tokens_range{begin, _pp_result->get_raw_tokens().size()};
+    };
+
+  h._share_offset_to_line_col_map(c.get_containing_header());
+
+  replay(raw_pp_tokens_range{first_range.begin, ifndef_range.begin});
+
+  const raw_pp_tokens_range new_ifndef_range = replay(ifndef_range);
+  _pp_result->_add_directive(new_ifndef_range);
+  ++_cond_incl_nesting;
+  _push_cond_incl(new_ifndef_range.begin);
+  _cond_incl_states.top().directive_ranges.push_back(new_ifndef_range);
+  _cond_incl_states.top().um += guard_macro;
+
+  const raw_pp_tokens_range new_endif_range = replay(endif_range);
+  _cond_incl_states.top().directive_ranges.push_back(new_endif_range);
+  _pop_cond_incl(new_endif_range.end);
+  --_cond_incl_nesting;
+  _pp_result->_add_directive(new_endif_range);
+
+  replay(raw_pp_tokens_range{endif_range.end, first_range.end});
+  h._set_range_end(_pp_result->get_raw_tokens().size());
+}
+
 void preprocessor::_push_cond_incl(const raw_pp_token_index range_begin)
 {
   pp_result::conditional_inclusion_node &node
@@ -1824,7 +1989,7 @@ _eval_conditional_inclusion(const raw_pp_tokens_range &directive_range)
 			 raw_pp_tokens_range{tok_index, tok_index});
       }
 
-      _pp_token tok{it_raw_tok->get_type(), it_raw_tok->get_value(),
+      _pp_token tok{it_raw_tok->get_type(), it_raw_tok->get_interned_value(),
 		    raw_pp_tokens_range{tok_index}};
       ++it_raw_tok;
       return tok;
@@ -1838,32 +2003,67 @@ _eval_conditional_inclusion(const raw_pp_tokens_range &directive_range)
       return _emit_pp_token(*_pp_result, std::move(tok));
     };
 
+  // Expand the whole condition upfront and look its result up in
+  // the cache before going through the parser.
   const pp_tokens::size_type temp_tokens_tail_begin
     = _pp_result->get_pp_tokens().size();
-  yy::pp_expr_parser_driver pd(exp_read_tok, *_pp_result);
-  try {
-    pd.parse();
-  } catch (const pp_except&) {
-    _remarks += pd.get_remarks();
-    pd.get_remarks().clear();
-    throw;
-  } catch (const parse_except&) {
-    _remarks += pd.get_remarks();
-    pd.get_remarks().clear();
-    throw;
+  pp_token_index last_index;
+  do {
+    last_index = exp_read_tok();
+  } while (!_pp_result->get_pp_tokens()[last_index].is_eof());
+
+  _cond_incl_expr_type expr;
+  for (pp_token_index i = temp_tokens_tail_begin; i < last_index; ++i) {
+    const pp_token &tok = _pp_result->get_pp_tokens()[i];
+    if (!tok.is_type_any_of<pp_token::type::ws,
+			    pp_token::type::empty,
+			    pp_token::type::newline>()) {
+      expr.emplace_back(tok.get_type(), tok.get_interned_value());
+    }
   }
 
-  ast::ast_pp_expr a = pd.grab_result();
   bool result;
-  try {
-    result = a.evaluate(_arch);
-  } catch (const semantic_except&) {
+  const auto it_cached = _cond_incl_results.find(expr);
+  if (it_cached != _cond_incl_results.end()) {
+    result = it_cached->second;
+  } else {
+    pp_token_index next_index = temp_tokens_tail_begin;
+    auto expanded_read_tok =
+      [&]() -> pp_token_index {
+	assert(next_index <= last_index);
+	return next_index++;
+      };
+
+    yy::pp_expr_parser_driver pd(expanded_read_tok, *_pp_result);
+    try {
+      pd.parse();
+    } catch (const pp_except&) {
+      _remarks += pd.get_remarks();
+      pd.get_remarks().clear();
+      throw;
+    } catch (const parse_except&) {
+      _remarks += pd.get_remarks();
+      pd.get_remarks().clear();
+      throw;
+    }
+
+    ast::ast_pp_expr a = pd.grab_result();
+    try {
+      result = a.evaluate(_arch);
+    } catch (const semantic_except&) {
+      _remarks += a.get_remarks();
+      a.get_remarks().clear();
+      throw;
+    }
+
+    // Conditions yielding any diagnostics get evaluated again on
+    // each occurrence, so that these will get reported each time.
+    if (pd.get_remarks().empty() && a.get_remarks().empty())
+      _cond_incl_results.insert(std::make_pair(std::move(expr), result));
+
     _remarks += a.get_remarks();
     a.get_remarks().clear();
-    throw;
   }
-  _remarks += a.get_remarks();
-  a.get_remarks().clear();
 
   auto um_mnc = _pp_result->_drop_pp_tokens_tail(temp_tokens_tail_begin);
   _cond_incl_states.top().um += std::move(um_mnc.first);
@@ -2224,7 +2424,7 @@ void preprocessor::_macro_instance::_add_concat_token(const _pp_token &tok)
   }
 
   if (!_concat_token) {
-    _concat_token.reset(new _pp_token(tok.get_type(), tok.get_value(),
+    _concat_token.reset(new _pp_token(tok.get_type(), tok.get_interned_value(),
 				      _invocation_range,
 				      _tok_expansion_history_init()));
     _concat_token->expansion_history() += tok.expansion_history();
@@ -2239,10 +2439,11 @@ _add_concat_token(const raw_pp_token &raw_tok)
   assert(!raw_tok.is_ws() && !raw_tok.is_newline() && !raw_tok.is_eof());
 
   if (!_concat_token) {
-    _concat_token.reset(new _pp_token(raw_tok.get_type(), raw_tok.get_value(),
+    _concat_token.reset(new _pp_token(raw_tok.get_type(),
+				      raw_tok.get_interned_value(),
 				      _invocation_range));
   } else {
-    _pp_token tok {raw_tok.get_type(), raw_tok.get_value(),
+    _pp_token tok {raw_tok.get_type(), raw_tok.get_interned_value(),
 		   _invocation_range};
     _concat_token->concat(tok, _preprocessor, _remarks);
   }
@@ -2395,7 +2596,8 @@ preprocessor::_pp_token preprocessor::_macro_instance::read_next_token()
       assert(!in_concat);
       assert(_cur_arg_it != _cur_arg->end());
 
-      auto tok = _pp_token(_cur_arg_it->get_type(), _cur_arg_it->get_value(),
+      auto tok = _pp_token(_cur_arg_it->get_type(),
+			   _cur_arg_it->get_interned_value(),
 			   _invocation_range, _tok_expansion_history_init(),
 			   _cur_arg_it->get_passed_through_raw_token());
       tok.expansion_history() += _cur_arg_it->expansion_history();
@@ -2517,7 +2719,7 @@ preprocessor::_pp_token preprocessor::_macro_instance::read_next_token()
 	  _last_tok_was_empty_or_ws = false;
 	  return _yield_concat_token();
 	} else {
-	  _pp_token tok{_it_repl->get_type(), _it_repl->get_value(),
+	  _pp_token tok{_it_repl->get_type(), _it_repl->get_interned_value(),
 			_invocation_range};
 	  _it_repl += 2;
 	  _last_tok_was_empty_or_ws = false;
@@ -2583,7 +2785,7 @@ preprocessor::_pp_token preprocessor::_macro_instance::read_next_token()
     return _handle_stringification();
   }
 
-  auto tok = _pp_token(_it_repl->get_type(), _it_repl->get_value(),
+  auto tok = _pp_token(_it_repl->get_type(), _it_repl->get_interned_value(),
 		       _invocation_range,
 		       _tok_expansion_history_init());
   ++_it_repl;
@@ -2611,4 +2813,135 @@ _cond_incl_state(pp_result::conditional_inclusion_node &_incl_node)
 {}
 
 
+preprocessor::_header_guard::
+_header_guard(const pp_result::conditional_inclusion_node &_cond_incl,
+	      const std::string &_macro_name)
+  : cond_incl(_cond_incl), macro_name(_macro_name)
+{}
+
+
+preprocessor::_macro_table::_macro_table()
+  : _slots(1024), _n_used(0), _n_live(0), _bloom(_slots.size() / 8)
+{}
+
+const pp_result::macro*
+preprocessor::_macro_table::find(const interned_string &name) const noexcept
+{
+  const std::size_t h = _hash(name);
+  if (!_bloom_test(h))
+    return nullptr;
+
+  return _slots[_find_slot(name, h)].m;
+}
+
+bool preprocessor::_macro_table::insert(const pp_result::macro &m)
+{
+  // Keep the load factor, including deleted slots, below 1/2.
+  if (2 * (_n_used + 1) > _slots.size())
+    _rehash();
+
+  const interned_string name(m.get_name());
+  const std::size_t h = _hash(name);
+  _slot &slot = _slots[_find_slot(name, h)];
+  if (slot.m)
+    return false;
+
+  slot = _slot{name, &m, false};
+  ++_n_used;
+  ++_n_live;
+  _bloom_set(h);
+  return true;
+}
+
+void preprocessor::_macro_table::erase(const interned_string &name) noexcept
+{
+  const std::size_t h = _hash(name);
+  if (!_bloom_test(h))
+    return;
+
+  _slot &slot = _slots[_find_slot(name, h)];
+  if (!slot.m)
+    return;
+
+  // The bloom filter can't forget about the name, it will get
+  // rebuilt with the next rehash.
+  slot.m = nullptr;
+  slot.deleted = true;
+  --_n_live;
+}
+
+std::size_t preprocessor::_macro_table::_hash(const interned_string &name)
+  noexcept
+{
+  // Interned strings hash to their address. Mix the bits well, the
+  // slot index as well as the bloom filter bits are taken from
+  // different parts of the result.
+  std::uint64_t h = name.hash();
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return static_cast<std::size_t>(h);
+}
+
+bool preprocessor::_macro_table::_bloom_test(const std::size_t h)
+  const noexcept
+{
+  const std::size_t mask = _bloom.size() * 64 - 1;
+  const std::size_t b1 = (h >> 16) & mask;
+  const std::size_t b2 = (h >> 40) & mask;
+  return ((_bloom[b1 / 64] >> (b1 % 64)) & 1) &&
+	 ((_bloom[b2 / 64] >> (b2 % 64)) & 1);
+}
+
+void preprocessor::_macro_table::_bloom_set(const std::size_t h) noexcept
+{
+  const std::size_t mask = _bloom.size() * 64 - 1;
+  const std::size_t b1 = (h >> 16) & mask;
+  const std::size_t b2 = (h >> 40) & mask;
+  _bloom[b1 / 64] |= static_cast<std::uint64_t>(1) << (b1 % 64);
+  _bloom[b2 / 64] |= static_cast<std::uint64_t>(1) << (b2 % 64);
+}
+
+std::size_t
+preprocessor::_macro_table::_find_slot(const interned_string &name,
+				       const std::size_t h) const noexcept
+{
+  // Linear probing. Returns either the slot containing name or
+  // the empty one terminating the probe sequence.
+  const std::size_t mask = _slots.size() - 1;
+  std::size_t i = h & mask;
+  while (_slots[i].m || _slots[i].deleted) {
+    if (_slots[i].m && _slots[i].name == name)
+      return i;
+    i = (i + 1) & mask;
+  }
+  return i;
+}
+
+void preprocessor::_macro_table::_rehash()
+{
+  // Double the size only if there are many live entries, otherwise
+  // the rehash merely purges deleted slots.
+  const std::size_t new_size =
+    4 * (_n_live + 1) > _slots.size() ? 2 * _slots.size() : _slots.size();
+
+  std::vector<_slot> old_slots(new_size);
+  old_slots.swap(_slots);
+  _bloom.assign(_slots.size() / 8, 0);
+  _n_used = 0;
+  for (const _slot &old_slot : old_slots) {
+    if (!old_slot.m)
+      continue;
+
+    const std::size_t h = _hash(old_slot.name);
+    _slots[_find_slot(old_slot.name, h)] = old_slot;
+    _bloom_set(h);
+    ++_n_used;
+  }
+  _n_live = _n_used;
+}
+
+
 preprocessor::_expansion_state::_expansion_state() = default;
@@ -21,6 +21,7 @@
 
 #include <stack>
 #include <map>
+#include <set>
 #include <memory>
 #include <string>
 #include <queue>
@@ -52,6 +53,11 @@ namespace klp
 
       pp_token_index read_next_token();
 
+      // Preprocess all of the input and pass the resulting tokens
+      // one by one to the consumer. Tokens and the macro_invocations
+      // they came from aren't retained in the pp_result afterwards.
+      void stream_tokens(const std::function<void(const pp_token&)> &consumer);
+
       const pp_result::header_inclusion_node&
       get_pending_token_source(const raw_pp_token_index tok);
 
@@ -94,13 +100,13 @@ namespace klp
 	static constexpr raw_pp_token_index not_passed_through =
 	  std::numeric_limits<raw_pp_token_index>::max();
 
-	_pp_token(const pp_token::type type, const std::string &value,
+	_pp_token(const pp_token::type type, const interned_string &value,
 		  const raw_pp_tokens_range &token_source,
 		  const pp_result::used_macros &eh,
 		  const raw_pp_token_index passed_through_raw_token
 			= not_passed_through);
 
-	_pp_token(const pp_token::type type, const std::string &value,
+	_pp_token(const pp_token::type type, const interned_string &value,
 		  const raw_pp_tokens_range &token_source,
 		  const raw_pp_token_index passed_through_raw_token
 			= not_passed_through);
@@ -111,12 +117,17 @@ namespace klp
 	}
 
 	const std::string& get_value() const noexcept
+	{
+	  return _value.str();
+	}
+
+	const interned_string& get_interned_value() const noexcept
 	{
 	  return _value;
 	}
 
 	void set_type_and_value(const pp_token::type type,
-				const std::string &value);
+				const interned_string &value);
 
 	const class pp_result::used_macros& expansion_history() const noexcept
 	{
@@ -151,7 +162,7 @@ namespace klp
 	bool is_punctuator(T &&s) const noexcept
 	{
 	  return (_type == pp_token::type::punctuator &&
-		  _value == std::forward<T>(s));
+		  _value.str() == std::forward<T>(s));
 	}
 
 	template <pp_token::type... types>
@@ -208,7 +219,7 @@ namespace klp
 	};
 
 	pp_token::type _type;
-	std::string _value;
+	interned_string _value;
 	raw_pp_tokens_range _token_source;
 	pp_result::macro_invocation * _macro_invocation;
 	raw_pp_token_index _passed_through_raw_token;
@@ -353,6 +364,61 @@ namespace klp
 
       void _handle_include(const raw_pp_tokens_range &directive_range);
 
+      struct _header_guard
+      {
+	_header_guard(const pp_result::conditional_inclusion_node &_cond_incl,
+		      const std::string &_macro_name);
+
+	std::reference_wrapper<const pp_result::conditional_inclusion_node>
+		cond_incl;
+	std::string macro_name;
+      };
+
+      // Maps macro names to the currently active definitions. This gets
+      // queried for every identifier encountered, and most of these
+      // aren't macros. So use open addressing, with a bloom filter in
+      // front for quickly rejecting non-macro identifiers.
+      class _macro_table
+      {
+      public:
+	_macro_table();
+
+	const pp_result::macro* find(const interned_string &name)
+	  const noexcept;
+
+	bool insert(const pp_result::macro &m);
+
+	void erase(const interned_string &name) noexcept;
+
+      private:
+	struct _slot
+	{
+	  interned_string name;
+	  const pp_result::macro *m;
+	  bool deleted;
+	};
+
+	static std::size_t _hash(const interned_string &name) noexcept;
+
+	bool _bloom_test(const std::size_t h) const noexcept;
+	void _bloom_set(const std::size_t h) noexcept;
+
+	std::size_t _find_slot(const interned_string &name,
+			       const std::size_t h) const noexcept;
+
+	void _rehash();
+
+	std::vector<_slot> _slots;
+	std::size_t _n_used;
+	std::size_t _n_live;
+	std::vector<std::uint64_t> _bloom;
+      };
+
+      void _register_header_guard(const pp_result::header_inclusion_node &h);
+
+      void _skip_guarded_header(pp_result::header_inclusion_child &h,
+				const _header_guard &guard,
+				const pp_result::macro &guard_macro);
 
 
       void _push_cond_incl(const raw_pp_token_index range_begin);
@@ -364,6 +430,13 @@ namespace klp
       bool
       _eval_conditional_inclusion(const raw_pp_tokens_range &directive_range);
 
+      // The value of an #if or #elif condition depends only on its
+      // macro-expanded, non-whitespace tokens. Results are remembered
+      // by those in order to avoid repeated parsing and evaluation.
+      typedef std::vector<std::pair<pp_token::type, interned_string>>
+	_cond_incl_expr_type;
+      typedef std::map<_cond_incl_expr_type, bool> _cond_incl_results_type;
+
       const pp_result::macro&
       _handle_macro_definition(const raw_pp_tokens_range &directive_range);
 
@@ -400,9 +473,11 @@ namespace klp
       std::size_t _cond_incl_nesting;
 
       std::stack<pp_tokenizer> _tokenizers;
+      std::map<std::string, _header_guard> _header_guards;
+      std::set<std::string> _once_only_headers;
       _expansion_state _root_expansion_state;
-      std::map<std::string,
-	       std::reference_wrapper<const pp_result::macro> > _macros;
+      _macro_table _macros;
+      _cond_incl_results_type _cond_incl_results;
 
       pp_result::macro_invocation *_cur_macro_invocation;
 
@@ -20,7 +20,8 @@
 
 using namespace klp::ccp;
 
-raw_pp_token::raw_pp_token(const pp_token::type type, const std::string &value,
+raw_pp_token::raw_pp_token(const pp_token::type type,
+			   const interned_string &value,
 			   const range_in_file &range_in_file)
   : _type(type), _value(value), _range_in_file(range_in_file)
 {}
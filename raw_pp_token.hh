@@ -21,6 +21,7 @@
 
 #include <string>
 #include "pp_token.hh"
+#include "interned_string.hh"
 #include "range_in_file.hh"
 
 namespace klp
@@ -30,7 +31,7 @@ namespace klp
     class raw_pp_token
     {
     public:
-      raw_pp_token(const pp_token::type type, const std::string &value,
+      raw_pp_token(const pp_token::type type, const interned_string &value,
 		   const range_in_file &range_in_file);
 
       bool operator==(const raw_pp_token &rhs) const noexcept;
@@ -41,6 +42,11 @@ namespace klp
       }
 
       const std::string& get_value() const noexcept
+      {
+	return _value.str();
+      }
+
+      const interned_string& get_interned_value() const noexcept
       {
 	return _value;
       }
@@ -54,7 +60,7 @@ namespace klp
       bool is_punctuator(T &&s) const noexcept
       {
 	return (_type == pp_token::type::punctuator &&
-		_value == std::forward<T>(s));
+		_value.str() == std::forward<T>(s));
       }
 
       template <pp_token::type... types>
@@ -100,7 +106,7 @@ namespace klp
       };
 
 
-      std::string _value;
+      interned_string _value;
       range_in_file _range_in_file;
       pp_token::type _type;
     };
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cerrno>
+#include <system_error>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "source_cache.hh"
+
+using namespace klp::ccp;
+
+source_cache::file_contents::file_contents(const std::string &filename)
+  : _filename(filename), _data(nullptr), _size(0)
+{
+  const int fd = open(_filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::system_error(errno, std::system_category(), _filename);
+
+  struct stat st;
+  if (fstat(fd, &st)) {
+    const int err = errno;
+    close(fd);
+    throw std::system_error(err, std::system_category(), _filename);
+  }
+
+  _size = static_cast<std::size_t>(st.st_size);
+  if (_size) {
+    // An empty file can't get mapped, leave _data at nullptr then.
+    void * const p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p == MAP_FAILED) {
+      const int err = errno;
+      close(fd);
+      throw std::system_error(err, std::system_category(), _filename);
+    }
+    _data = static_cast<const char *>(p);
+  }
+
+  close(fd);
+}
+
+source_cache::file_contents::~file_contents() noexcept
+{
+  if (_data)
+    munmap(const_cast<char *>(_data), _size);
+}
+
+
+std::shared_ptr<const source_cache::file_contents>
+source_cache::get(const std::string &filename)
+{
+  _cache_type &cache = _get_cache();
+  auto it = cache.find(filename);
+  if (it == cache.end()) {
+    it = cache.insert
+	   (std::make_pair(filename,
+			   std::make_shared<const file_contents>(filename)))
+	   .first;
+  }
+
+  return it->second;
+}
+
+source_cache::_cache_type& source_cache::_get_cache()
+{
+  static _cache_type cache;
+  return cache;
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019  SUSE Software Solutions Germany GmbH
+ *
+ * This file is part of klp-ccp.
+ *
+ * klp-ccp is free software: you can redistribute it and/or modify it
+ * under the terms of version 2 of the GNU General Public License as
+ * published by the Free Software Foundation.
+ *
+ * klp-ccp is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with klp-ccp. If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef SOURCE_CACHE_HH
+#define SOURCE_CACHE_HH
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace klp
+{
+  namespace ccp
+  {
+    // Process-wide cache of source file contents, keyed by the
+    // resolved file name as obtained from header_resolver. Files are
+    // mapped into memory on first request and the immutable mapping
+    // is shared by all readers, i.e. by the preprocessor's tokenizers
+    // as well as by the depreprocessor when writing the live patch.
+    class source_cache
+    {
+    public:
+      class file_contents
+      {
+      public:
+	file_contents(const std::string &filename);
+	~file_contents() noexcept;
+
+	file_contents(const file_contents&) = delete;
+	file_contents& operator=(const file_contents&) = delete;
+
+	const std::string& get_filename() const noexcept
+	{ return _filename; }
+
+	const char* begin() const noexcept
+	{ return _data; }
+
+	const char* end() const noexcept
+	{ return _data + _size; }
+
+	std::size_t size() const noexcept
+	{ return _size; }
+
+      private:
+	const std::string _filename;
+	const char *_data;
+	std::size_t _size;
+      };
+
+      static std::shared_ptr<const file_contents>
+      get(const std::string &filename);
+
+    private:
+      typedef std::map<std::string, std::shared_ptr<const file_contents>>
+	_cache_type;
+
+      static _cache_type& _get_cache();
+    };
+  }
+}
+
+#endif
@@ -43,11 +43,11 @@ file_source_reader::~file_source_reader() noexcept
   close (_fd);
 }
 
-source_reader::buffer_type file_source_reader::read()
+source_reader::chunk file_source_reader::read()
 {
-  _fill_buffer();
   _buf_pos += _buf.size();
-  return std::move(_buf);
+  _fill_buffer();
+  return chunk{_buf.data(), _buf.data() + _buf.size()};
 }
 
 void file_source_reader::read(buffer_type &to_buffer,
@@ -82,7 +82,7 @@ void file_source_reader::read(buffer_type &to_buffer,
       = _buf.cbegin() + (pos - _buf_pos);
     const buffer_type::size_type n
       = std::min(_buf.cend() - it_copy_begin, from_range.end - pos);
-    std::copy(it_copy_begin, it_copy_begin + n, std::back_inserter(to_buffer));
+    to_buffer.insert(to_buffer.end(), it_copy_begin, it_copy_begin + n);
     pos += n;
   }
 }
@@ -97,3 +97,37 @@ void file_source_reader::_fill_buffer()
 
   _buf.resize(static_cast<buffer_type::size_type>(r));
 }
+
+
+mmap_source_reader::mmap_source_reader(const std::string &filename)
+  : _contents(source_cache::get(filename)), _eof(false)
+{}
+
+mmap_source_reader::~mmap_source_reader() noexcept = default;
+
+source_reader::chunk mmap_source_reader::read()
+{
+  if (_eof)
+    return chunk{};
+
+  _eof = true;
+  return chunk{_contents->begin(), _contents->end()};
+}
+
+void mmap_source_reader::read(buffer_type &to_buffer,
+			      const range_in_file &from_range)
+{
+  if (from_range.begin == from_range.end)
+    return;
+
+  if (from_range.end < 0 ||
+      static_cast<std::size_t>(from_range.end) > _contents->size()) {
+    // Preliminary EOF.
+    throw std::system_error(ENXIO, std::system_category(),
+			    _contents->get_filename());
+  }
+
+  to_buffer.insert(to_buffer.end(),
+		   _contents->begin() + from_range.begin,
+		   _contents->begin() + from_range.end);
+}
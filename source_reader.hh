@@ -21,6 +21,8 @@
 
 #include <vector>
 #include <string>
+#include <memory>
+#include "source_cache.hh"
 
 namespace klp
 {
@@ -33,9 +35,29 @@ namespace klp
     public:
       typedef std::vector<char> buffer_type;
 
+      struct chunk
+      {
+	chunk() noexcept
+	  : begin(nullptr), end(nullptr)
+	{}
+
+	chunk(const char * const _begin, const char * const _end) noexcept
+	  : begin(_begin), end(_end)
+	{}
+
+	bool empty() const noexcept
+	{ return begin == end; }
+
+	const char *begin;
+	const char *end;
+      };
+
       virtual ~source_reader() noexcept;
 
-      virtual buffer_type read() = 0;
+      // Returns the next chunk of the file's contents. The memory
+      // referenced remains valid until the next invocation of any of
+      // the read() methods. An empty chunk signals EOF.
+      virtual chunk read() = 0;
 
       virtual void read(buffer_type &to_buffer,
 			const range_in_file &from_range) = 0;
@@ -48,7 +70,7 @@ namespace klp
 
       virtual ~file_source_reader() noexcept override;
 
-      virtual buffer_type read() override;
+      virtual chunk read() override;
 
       virtual void read(buffer_type &to_buffer,
 			const range_in_file &from_range) override;
@@ -61,6 +83,26 @@ namespace klp
       buffer_type _buf;
       std::streamoff _buf_pos;
     };
+
+    // Hands out views into the file's memory mapping as maintained by
+    // the process-wide source_cache instead of copying through a
+    // bounce buffer.
+    class mmap_source_reader final : public source_reader
+    {
+    public:
+      mmap_source_reader(const std::string &filename);
+
+      virtual ~mmap_source_reader() noexcept override;
+
+      virtual chunk read() override;
+
+      virtual void read(buffer_type &to_buffer,
+			const range_in_file &from_range) override;
+
+    private:
+      const std::shared_ptr<const source_cache::file_contents> _contents;
+      bool _eof;
+    };
   }
 }
 
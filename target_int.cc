@@ -18,6 +18,7 @@
 
 #include <cassert>
 #include <stdexcept>
+#include <cstdint>
 #include "target_int.hh"
 #include "target_float.hh"
 
@@ -105,6 +106,13 @@ target_int::operator bool() const noexcept
 
 target_int target_int::operator-() const
 {
+  if (_is_small()) {
+    const __int128 r = -_get_small();
+    if (_is_signed && !_fits_small(r))
+      throw std::overflow_error("integer overflow");
+    return _from_small(r);
+  }
+
   mpa::limbs ls = _limbs.complement();
   assert(ls.size() == _n_limbs());
   _propagate_sign_to_high(ls);
@@ -120,6 +128,9 @@ target_int target_int::operator-() const
 
 target_int target_int::operator~() const
 {
+  if (_is_small())
+    return _from_small(~_get_small());
+
   mpa::limbs ls = ~_limbs;
   assert(ls.size() == _n_limbs());
   _propagate_sign_to_high(ls);
@@ -130,6 +141,13 @@ target_int target_int::operator~() const
 target_int target_int::operator+(const target_int &op) const
 {
   _assert_same_prec_and_signedness(op);
+  if (_is_small()) {
+    const __int128 r = _get_small() + op._get_small();
+    if (_is_signed && !_fits_small(r))
+      throw std::overflow_error("integer overflow");
+    return _from_small(r);
+  }
+
   mpa::limbs ls = _limbs + op._limbs;
   if (_is_signed && _is_negative() == op._is_negative() &&
       ls.test_bit(_prec) != _is_negative())
@@ -144,6 +162,13 @@ target_int target_int::operator+(const target_int &op) const
 target_int target_int::operator-(const target_int &op) const
 {
   _assert_same_prec_and_signedness(op);
+  if (_is_small()) {
+    const __int128 r = _get_small() - op._get_small();
+    if (_is_signed && !_fits_small(r))
+      throw std::overflow_error("integer overflow");
+    return _from_small(r);
+  }
+
   mpa::limbs ls = _limbs - op._limbs;
   if (_is_signed && _is_negative() != op._is_negative() &&
       ls.test_bit(_prec) != _is_negative())
@@ -157,6 +182,19 @@ target_int target_int::operator-(const target_int &op) const
 target_int target_int::operator*(const target_int &op) const
 {
   _assert_same_prec_and_signedness(op);
+  if (_is_small()) {
+    // As with the generic implementation below, the product's
+    // magnitude must be less than 2^_prec, regardless of the sign.
+    const __int128 a = _get_small(), b = op._get_small();
+    const unsigned __int128 m =
+      (static_cast<unsigned __int128>(a < 0 ? -a : a) *
+       static_cast<unsigned __int128>(b < 0 ? -b : b));
+    if (m >> _prec)
+      throw std::overflow_error("integer overflow");
+    const __int128 r = static_cast<__int128>(m);
+    return _from_small((a < 0) != (b < 0) ? -r : r);
+  }
+
 
   if (_is_signed && _is_negative() && op._is_negative()) {
     mpa::limbs p = _limbs.complement() * op._limbs.complement();
@@ -194,6 +232,13 @@ target_int target_int::operator*(const target_int &op) const
 target_int target_int::operator/(const target_int &op) const
 {
   _assert_same_prec_and_signedness(op);
+  if (_is_small()) {
+    const __int128 b = op._get_small();
+    if (!b)
+      throw std::invalid_argument("division by zero");
+    return _from_small(_get_small() / b);
+  }
+
 
   if (_is_signed && _is_negative() && op._is_negative()) {
     std::pair<mpa::limbs, mpa::limbs> &&qr =
@@ -232,6 +277,13 @@ target_int target_int::operator/(const target_int &op) const
 target_int target_int::operator%(const target_int &op) const
 {
   _assert_same_prec_and_signedness(op);
+  if (_is_small()) {
+    const __int128 b = op._get_small();
+    if (!b)
+      throw std::invalid_argument("division by zero");
+    return _from_small(_get_small() % b);
+  }
+
 
   if (_is_signed && _is_negative() && op._is_negative()) {
     std::pair<mpa::limbs, mpa::limbs> &&qr =
@@ -297,6 +349,15 @@ target_int target_int::operator<<(const target_int &op) const
   if (distance >= width())
     throw std::overflow_error("integer overflow");
 
+  if (_is_small()) {
+    const __int128 r =
+      static_cast<__int128>(static_cast<unsigned __int128>(_get_small())
+			    << distance);
+    if (_is_signed && !_fits_small(r))
+      throw std::overflow_error("integer overflow");
+    return _from_small(r);
+  }
+
   mpa::limbs ls = _limbs;
   ls.resize(mpa::limbs::width_to_size(width() + distance));
   if (_is_signed)
@@ -318,6 +379,9 @@ target_int target_int::operator>>(const target_int &op) const
   if (distance >= width())
     throw std::overflow_error("integer overflow");
 
+  if (_is_small())
+    return _from_small(_get_small() >> distance);
+
   const bool fill_value = (_is_signed && _is_negative()) ? true : false;
   mpa::limbs ls = _limbs.rshift(distance, fill_value);
   return target_int(_prec, _is_signed, std::move(ls));
@@ -387,6 +451,50 @@ target_int target_int::create_one(const mpa::limbs::size_type prec,
   return target_int(prec, is_signed, std::move(ls));
 }
 
+__int128 target_int::_get_small() const noexcept
+{
+  assert(_is_small());
+  std::uint64_t u = 0;
+  for (mpa::limbs::size_type i = 0, n = 0; i < _limbs.size();
+       ++i, n += mpa::limb::width) {
+    u |= static_cast<std::uint64_t>(_limbs[i].value()) << n;
+  }
+
+  if (width() < 64)
+    u &= (static_cast<std::uint64_t>(1) << width()) - 1;
+
+  if (_is_signed && _is_negative())
+    return static_cast<__int128>(u) - (static_cast<__int128>(1) << width());
+  return u;
+}
+
+target_int target_int::_from_small(const __int128 value) const
+{
+  // Reduce modulo 2^width() and, for signed types, sign extend.
+  std::uint64_t u = static_cast<std::uint64_t>(value);
+  if (width() < 64) {
+    const std::uint64_t m = (static_cast<std::uint64_t>(1) << width()) - 1;
+    u &= m;
+    if (_is_signed && (u >> _prec))
+      u |= ~m;
+  }
+
+  mpa::limbs ls;
+  ls.resize(_n_limbs());
+  for (mpa::limbs::size_type i = 0, n = 0; i < ls.size();
+       ++i, n += mpa::limb::width) {
+    ls[i] = mpa::limb(static_cast<mpa::limb::limb_type>(u >> n));
+  }
+
+  return target_int(_prec, _is_signed, std::move(ls));
+}
+
+bool target_int::_fits_small(const __int128 value) const noexcept
+{
+  const __int128 bound = static_cast<__int128>(1) << _prec;
+  return _is_signed ? (value >= -bound && value < bound) : value < bound;
+}
+
 mpa::limbs::size_type target_int::_to_size_type() const
 {
   if (_is_signed && _is_negative()) {
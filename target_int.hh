@@ -108,6 +108,18 @@ namespace klp
 				   const bool is_signed);
 
     private:
+      // Values of types at most _small_width bits wide get operated
+      // on natively, with intermediate results computed in twice that
+      // width such that overflows can be detected.
+      static constexpr mpa::limbs::size_type _small_width = 64;
+
+      bool _is_small() const noexcept
+      { return width() <= _small_width; }
+
+      __int128 _get_small() const noexcept;
+      target_int _from_small(const __int128 value) const;
+      bool _fits_small(const __int128 value) const noexcept;
+
       void _assert_same_prec_and_signedness(const target_int &op)
 	const noexcept;
 
@@ -875,6 +875,37 @@ static int limbs_test31()
   return 0;
 }
 
+static int limbs_test32()
+{
+  // Division by and multiplication with a single limb.
+  const limbs u({~limb(0), limb(1), ~limb(1)});
+  const limbs v{static_cast<limb::limb_type>(3) << (limb::width - 2) | 7};
+
+  const auto qr = u / v;
+  if (qr.first.size() != u.size() || qr.second.size() != 1)
+    return -1;
+
+  if (qr.second[0] >= v[0])
+    return -2;
+
+  limbs p = qr.first * v;
+  if (p.size() != u.size() + 1)
+    return -3;
+
+  p = p + qr.second;
+  for (limbs::size_type i = 0; i < u.size(); ++i) {
+    if (p[i] != u[i])
+      return -4;
+  }
+  if (p.is_any_set_at_or_above(u.width()))
+    return -5;
+
+  if (v * qr.first != qr.first * v)
+    return -6;
+
+  return 0;
+}
+
 
 #define TEST_ENTRY(t)				\
   { "mpa:" #t, t }
@@ -931,6 +962,7 @@ static const struct test_entry {
   TEST_ENTRY(limbs_test29),
   TEST_ENTRY(limbs_test30),
   TEST_ENTRY(limbs_test31),
+  TEST_ENTRY(limbs_test32),
   { NULL, NULL }
 };
 
@@ -0,0 +1,9 @@
+#ifndef HEADERS_8_INTERNAL_H
+#define HEADERS_8_INTERNAL_H
+
+static int g(void)
+{
+	return 0;
+}
+
+#endif
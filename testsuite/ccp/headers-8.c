@@ -0,0 +1,9 @@
+#include "headers-8.h"
+#include "headers-8-internal.h"
+#include "headers-8.h"
+
+int pu_f(void)
+{
+	g();
+	return H;
+}
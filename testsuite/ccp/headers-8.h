@@ -0,0 +1,8 @@
+#ifndef HEADERS_8_H
+#define HEADERS_8_H
+
+#include "headers-8-internal.h"
+
+#define H 1
+
+#endif
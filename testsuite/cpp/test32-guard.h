@@ -0,0 +1,7 @@
+/* A classic include guard. */
+#ifndef TEST32_GUARD_H
+#define TEST32_GUARD_H
+
+int a;
+
+#endif
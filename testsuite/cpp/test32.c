@@ -0,0 +1,7 @@
+#include "test32-guard.h"
+#include "test32-guard.h"
+#include "test32-once.h"
+#include "test32-once.h"
+#undef TEST32_GUARD_H
+#include "test32-guard.h"
+int main(void) { return a + b; }
@@ -0,0 +1,15 @@
+#define X(a) int a;
+#include "test33.h"
+#undef X
+
+#define X(a) a,
+int v[] = {
+#include "test33.h"
+};
+#undef X
+
+#define X(a) #a,
+const char *s[] = {
+#include "test33.h"
+};
+#undef X
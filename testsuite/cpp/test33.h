@@ -0,0 +1,4 @@
+/* An x-macro style header, meant to get included multiple times. */
+X(foo)
+X(bar) \
+X(baz)
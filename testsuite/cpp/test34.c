@@ -0,0 +1,21 @@
+/* Long runs of identifier characters, whitespace, comment and string
+   bodies, interrupted by line continuations at various places.  */
+#define a_rather_long_macro_name_of_more_than_thirty_two_characters 1
+int a_rather_long_macro_name_of_more_than_thirty_two_characters_not = a_rather_long_macro_name_of_more_than_thirty_two_characters;
+int a_rather_long_iden\
+tifier_split_by_a_line_continuation_somewhere_in_the_middle;
+int                                        x1;
+int                 \
+                    x2;
+int /* a comment that is considerably longer than thirty two bytes */ x3;
+int /* a comment that is considerably longer than thirty two bytes *\
+/ x4;
+/* a multi-line comment
+                                                         spanning lines **/ int x5;
+const char *s1 = "a string literal that is longer than thirty two bytes";
+const char *s2 = "a string literal with an \"escaped\" quote, \\ and a \
+line continuation in it";
+const char c = 'x';
+// a C++ comment that is considerably longer than thirty two bytes \
+continued on the next line
+int x6;
@@ -0,0 +1,866 @@
+/* Enough macro definitions and removals to make the preprocessor's
+   macro table grow and get rehashed.  */
+#define M0 0
+#define M1 1
+#define M2 2
+#define M3 3
+#define M4 4
+#define M5 5
+#define M6 6
+#define M7 7
+#define M8 8
+#define M9 9
+#define M10 10
+#define M11 11
+#define M12 12
+#define M13 13
+#define M14 14
+#define M15 15
+#define M16 16
+#define M17 17
+#define M18 18
+#define M19 19
+#define M20 20
+#define M21 21
+#define M22 22
+#define M23 23
+#define M24 24
+#define M25 25
+#define M26 26
+#define M27 27
+#define M28 28
+#define M29 29
+#define M30 30
+#define M31 31
+#define M32 32
+#define M33 33
+#define M34 34
+#define M35 35
+#define M36 36
+#define M37 37
+#define M38 38
+#define M39 39
+#define M40 40
+#define M41 41
+#define M42 42
+#define M43 43
+#define M44 44
+#define M45 45
+#define M46 46
+#define M47 47
+#define M48 48
+#define M49 49
+#define M50 50
+#define M51 51
+#define M52 52
+#define M53 53
+#define M54 54
+#define M55 55
+#define M56 56
+#define M57 57
+#define M58 58
+#define M59 59
+#define M60 60
+#define M61 61
+#define M62 62
+#define M63 63
+#define M64 64
+#define M65 65
+#define M66 66
+#define M67 67
+#define M68 68
+#define M69 69
+#define M70 70
+#define M71 71
+#define M72 72
+#define M73 73
+#define M74 74
+#define M75 75
+#define M76 76
+#define M77 77
+#define M78 78
+#define M79 79
+#define M80 80
+#define M81 81
+#define M82 82
+#define M83 83
+#define M84 84
+#define M85 85
+#define M86 86
+#define M87 87
+#define M88 88
+#define M89 89
+#define M90 90
+#define M91 91
+#define M92 92
+#define M93 93
+#define M94 94
+#define M95 95
+#define M96 96
+#define M97 97
+#define M98 98
+#define M99 99
+#define M100 100
+#define M101 101
+#define M102 102
+#define M103 103
+#define M104 104
+#define M105 105
+#define M106 106
+#define M107 107
+#define M108 108
+#define M109 109
+#define M110 110
+#define M111 111
+#define M112 112
+#define M113 113
+#define M114 114
+#define M115 115
+#define M116 116
+#define M117 117
+#define M118 118
+#define M119 119
+#define M120 120
+#define M121 121
+#define M122 122
+#define M123 123
+#define M124 124
+#define M125 125
+#define M126 126
+#define M127 127
+#define M128 128
+#define M129 129
+#define M130 130
+#define M131 131
+#define M132 132
+#define M133 133
+#define M134 134
+#define M135 135
+#define M136 136
+#define M137 137
+#define M138 138
+#define M139 139
+#define M140 140
+#define M141 141
+#define M142 142
+#define M143 143
+#define M144 144
+#define M145 145
+#define M146 146
+#define M147 147
+#define M148 148
+#define M149 149
+#define M150 150
+#define M151 151
+#define M152 152
+#define M153 153
+#define M154 154
+#define M155 155
+#define M156 156
+#define M157 157
+#define M158 158
+#define M159 159
+#define M160 160
+#define M161 161
+#define M162 162
+#define M163 163
+#define M164 164
+#define M165 165
+#define M166 166
+#define M167 167
+#define M168 168
+#define M169 169
+#define M170 170
+#define M171 171
+#define M172 172
+#define M173 173
+#define M174 174
+#define M175 175
+#define M176 176
+#define M177 177
+#define M178 178
+#define M179 179
+#define M180 180
+#define M181 181
+#define M182 182
+#define M183 183
+#define M184 184
+#define M185 185
+#define M186 186
+#define M187 187
+#define M188 188
+#define M189 189
+#define M190 190
+#define M191 191
+#define M192 192
+#define M193 193
+#define M194 194
+#define M195 195
+#define M196 196
+#define M197 197
+#define M198 198
+#define M199 199
+#define M200 200
+#define M201 201
+#define M202 202
+#define M203 203
+#define M204 204
+#define M205 205
+#define M206 206
+#define M207 207
+#define M208 208
+#define M209 209
+#define M210 210
+#define M211 211
+#define M212 212
+#define M213 213
+#define M214 214
+#define M215 215
+#define M216 216
+#define M217 217
+#define M218 218
+#define M219 219
+#define M220 220
+#define M221 221
+#define M222 222
+#define M223 223
+#define M224 224
+#define M225 225
+#define M226 226
+#define M227 227
+#define M228 228
+#define M229 229
+#define M230 230
+#define M231 231
+#define M232 232
+#define M233 233
+#define M234 234
+#define M235 235
+#define M236 236
+#define M237 237
+#define M238 238
+#define M239 239
+#define M240 240
+#define M241 241
+#define M242 242
+#define M243 243
+#define M244 244
+#define M245 245
+#define M246 246
+#define M247 247
+#define M248 248
+#define M249 249
+#define M250 250
+#define M251 251
+#define M252 252
+#define M253 253
+#define M254 254
+#define M255 255
+#define M256 256
+#define M257 257
+#define M258 258
+#define M259 259
+#define M260 260
+#define M261 261
+#define M262 262
+#define M263 263
+#define M264 264
+#define M265 265
+#define M266 266
+#define M267 267
+#define M268 268
+#define M269 269
+#define M270 270
+#define M271 271
+#define M272 272
+#define M273 273
+#define M274 274
+#define M275 275
+#define M276 276
+#define M277 277
+#define M278 278
+#define M279 279
+#define M280 280
+#define M281 281
+#define M282 282
+#define M283 283
+#define M284 284
+#define M285 285
+#define M286 286
+#define M287 287
+#define M288 288
+#define M289 289
+#define M290 290
+#define M291 291
+#define M292 292
+#define M293 293
+#define M294 294
+#define M295 295
+#define M296 296
+#define M297 297
+#define M298 298
+#define M299 299
+#define M300 300
+#define M301 301
+#define M302 302
+#define M303 303
+#define M304 304
+#define M305 305
+#define M306 306
+#define M307 307
+#define M308 308
+#define M309 309
+#define M310 310
+#define M311 311
+#define M312 312
+#define M313 313
+#define M314 314
+#define M315 315
+#define M316 316
+#define M317 317
+#define M318 318
+#define M319 319
+#define M320 320
+#define M321 321
+#define M322 322
+#define M323 323
+#define M324 324
+#define M325 325
+#define M326 326
+#define M327 327
+#define M328 328
+#define M329 329
+#define M330 330
+#define M331 331
+#define M332 332
+#define M333 333
+#define M334 334
+#define M335 335
+#define M336 336
+#define M337 337
+#define M338 338
+#define M339 339
+#define M340 340
+#define M341 341
+#define M342 342
+#define M343 343
+#define M344 344
+#define M345 345
+#define M346 346
+#define M347 347
+#define M348 348
+#define M349 349
+#define M350 350
+#define M351 351
+#define M352 352
+#define M353 353
+#define M354 354
+#define M355 355
+#define M356 356
+#define M357 357
+#define M358 358
+#define M359 359
+#define M360 360
+#define M361 361
+#define M362 362
+#define M363 363
+#define M364 364
+#define M365 365
+#define M366 366
+#define M367 367
+#define M368 368
+#define M369 369
+#define M370 370
+#define M371 371
+#define M372 372
+#define M373 373
+#define M374 374
+#define M375 375
+#define M376 376
+#define M377 377
+#define M378 378
+#define M379 379
+#define M380 380
+#define M381 381
+#define M382 382
+#define M383 383
+#define M384 384
+#define M385 385
+#define M386 386
+#define M387 387
+#define M388 388
+#define M389 389
+#define M390 390
+#define M391 391
+#define M392 392
+#define M393 393
+#define M394 394
+#define M395 395
+#define M396 396
+#define M397 397
+#define M398 398
+#define M399 399
+#undef M0
+#undef M2
+#undef M4
+#undef M6
+#undef M8
+#undef M10
+#undef M12
+#undef M14
+#undef M16
+#undef M18
+#undef M20
+#undef M22
+#undef M24
+#undef M26
+#undef M28
+#undef M30
+#undef M32
+#undef M34
+#undef M36
+#undef M38
+#undef M40
+#undef M42
+#undef M44
+#undef M46
+#undef M48
+#undef M50
+#undef M52
+#undef M54
+#undef M56
+#undef M58
+#undef M60
+#undef M62
+#undef M64
+#undef M66
+#undef M68
+#undef M70
+#undef M72
+#undef M74
+#undef M76
+#undef M78
+#undef M80
+#undef M82
+#undef M84
+#undef M86
+#undef M88
+#undef M90
+#undef M92
+#undef M94
+#undef M96
+#undef M98
+#undef M100
+#undef M102
+#undef M104
+#undef M106
+#undef M108
+#undef M110
+#undef M112
+#undef M114
+#undef M116
+#undef M118
+#undef M120
+#undef M122
+#undef M124
+#undef M126
+#undef M128
+#undef M130
+#undef M132
+#undef M134
+#undef M136
+#undef M138
+#undef M140
+#undef M142
+#undef M144
+#undef M146
+#undef M148
+#undef M150
+#undef M152
+#undef M154
+#undef M156
+#undef M158
+#undef M160
+#undef M162
+#undef M164
+#undef M166
+#undef M168
+#undef M170
+#undef M172
+#undef M174
+#undef M176
+#undef M178
+#undef M180
+#undef M182
+#undef M184
+#undef M186
+#undef M188
+#undef M190
+#undef M192
+#undef M194
+#undef M196
+#undef M198
+#undef M200
+#undef M202
+#undef M204
+#undef M206
+#undef M208
+#undef M210
+#undef M212
+#undef M214
+#undef M216
+#undef M218
+#undef M220
+#undef M222
+#undef M224
+#undef M226
+#undef M228
+#undef M230
+#undef M232
+#undef M234
+#undef M236
+#undef M238
+#undef M240
+#undef M242
+#undef M244
+#undef M246
+#undef M248
+#undef M250
+#undef M252
+#undef M254
+#undef M256
+#undef M258
+#undef M260
+#undef M262
+#undef M264
+#undef M266
+#undef M268
+#undef M270
+#undef M272
+#undef M274
+#undef M276
+#undef M278
+#undef M280
+#undef M282
+#undef M284
+#undef M286
+#undef M288
+#undef M290
+#undef M292
+#undef M294
+#undef M296
+#undef M298
+#undef M300
+#undef M302
+#undef M304
+#undef M306
+#undef M308
+#undef M310
+#undef M312
+#undef M314
+#undef M316
+#undef M318
+#undef M320
+#undef M322
+#undef M324
+#undef M326
+#undef M328
+#undef M330
+#undef M332
+#undef M334
+#undef M336
+#undef M338
+#undef M340
+#undef M342
+#undef M344
+#undef M346
+#undef M348
+#undef M350
+#undef M352
+#undef M354
+#undef M356
+#undef M358
+#undef M360
+#undef M362
+#undef M364
+#undef M366
+#undef M368
+#undef M370
+#undef M372
+#undef M374
+#undef M376
+#undef M378
+#undef M380
+#undef M382
+#undef M384
+#undef M386
+#undef M388
+#undef M390
+#undef M392
+#undef M394
+#undef M396
+#undef M398
+int a0 = M0;
+int a20 = M20;
+int a40 = M40;
+int a60 = M60;
+int a80 = M80;
+int a100 = M100;
+int a120 = M120;
+int a140 = M140;
+int a160 = M160;
+int a180 = M180;
+int a200 = M200;
+int a220 = M220;
+int a240 = M240;
+int a260 = M260;
+int a280 = M280;
+int a300 = M300;
+int a320 = M320;
+int a340 = M340;
+int a360 = M360;
+int a380 = M380;
+#define M0 (0 + 1)
+#define M2 (2 + 1)
+#define M4 (4 + 1)
+#define M6 (6 + 1)
+#define M8 (8 + 1)
+#define M10 (10 + 1)
+#define M12 (12 + 1)
+#define M14 (14 + 1)
+#define M16 (16 + 1)
+#define M18 (18 + 1)
+#define M20 (20 + 1)
+#define M22 (22 + 1)
+#define M24 (24 + 1)
+#define M26 (26 + 1)
+#define M28 (28 + 1)
+#define M30 (30 + 1)
+#define M32 (32 + 1)
+#define M34 (34 + 1)
+#define M36 (36 + 1)
+#define M38 (38 + 1)
+#define M40 (40 + 1)
+#define M42 (42 + 1)
+#define M44 (44 + 1)
+#define M46 (46 + 1)
+#define M48 (48 + 1)
+#define M50 (50 + 1)
+#define M52 (52 + 1)
+#define M54 (54 + 1)
+#define M56 (56 + 1)
+#define M58 (58 + 1)
+#define M60 (60 + 1)
+#define M62 (62 + 1)
+#define M64 (64 + 1)
+#define M66 (66 + 1)
+#define M68 (68 + 1)
+#define M70 (70 + 1)
+#define M72 (72 + 1)
+#define M74 (74 + 1)
+#define M76 (76 + 1)
+#define M78 (78 + 1)
+#define M80 (80 + 1)
+#define M82 (82 + 1)
+#define M84 (84 + 1)
+#define M86 (86 + 1)
+#define M88 (88 + 1)
+#define M90 (90 + 1)
+#define M92 (92 + 1)
+#define M94 (94 + 1)
+#define M96 (96 + 1)
+#define M98 (98 + 1)
+#define M100 (100 + 1)
+#define M102 (102 + 1)
+#define M104 (104 + 1)
+#define M106 (106 + 1)
+#define M108 (108 + 1)
+#define M110 (110 + 1)
+#define M112 (112 + 1)
+#define M114 (114 + 1)
+#define M116 (116 + 1)
+#define M118 (118 + 1)
+#define M120 (120 + 1)
+#define M122 (122 + 1)
+#define M124 (124 + 1)
+#define M126 (126 + 1)
+#define M128 (128 + 1)
+#define M130 (130 + 1)
+#define M132 (132 + 1)
+#define M134 (134 + 1)
+#define M136 (136 + 1)
+#define M138 (138 + 1)
+#define M140 (140 + 1)
+#define M142 (142 + 1)
+#define M144 (144 + 1)
+#define M146 (146 + 1)
+#define M148 (148 + 1)
+#define M150 (150 + 1)
+#define M152 (152 + 1)
+#define M154 (154 + 1)
+#define M156 (156 + 1)
+#define M158 (158 + 1)
+#define M160 (160 + 1)
+#define M162 (162 + 1)
+#define M164 (164 + 1)
+#define M166 (166 + 1)
+#define M168 (168 + 1)
+#define M170 (170 + 1)
+#define M172 (172 + 1)
+#define M174 (174 + 1)
+#define M176 (176 + 1)
+#define M178 (178 + 1)
+#define M180 (180 + 1)
+#define M182 (182 + 1)
+#define M184 (184 + 1)
+#define M186 (186 + 1)
+#define M188 (188 + 1)
+#define M190 (190 + 1)
+#define M192 (192 + 1)
+#define M194 (194 + 1)
+#define M196 (196 + 1)
+#define M198 (198 + 1)
+#define M200 (200 + 1)
+#define M202 (202 + 1)
+#define M204 (204 + 1)
+#define M206 (206 + 1)
+#define M208 (208 + 1)
+#define M210 (210 + 1)
+#define M212 (212 + 1)
+#define M214 (214 + 1)
+#define M216 (216 + 1)
+#define M218 (218 + 1)
+#define M220 (220 + 1)
+#define M222 (222 + 1)
+#define M224 (224 + 1)
+#define M226 (226 + 1)
+#define M228 (228 + 1)
+#define M230 (230 + 1)
+#define M232 (232 + 1)
+#define M234 (234 + 1)
+#define M236 (236 + 1)
+#define M238 (238 + 1)
+#define M240 (240 + 1)
+#define M242 (242 + 1)
+#define M244 (244 + 1)
+#define M246 (246 + 1)
+#define M248 (248 + 1)
+#define M250 (250 + 1)
+#define M252 (252 + 1)
+#define M254 (254 + 1)
+#define M256 (256 + 1)
+#define M258 (258 + 1)
+#define M260 (260 + 1)
+#define M262 (262 + 1)
+#define M264 (264 + 1)
+#define M266 (266 + 1)
+#define M268 (268 + 1)
+#define M270 (270 + 1)
+#define M272 (272 + 1)
+#define M274 (274 + 1)
+#define M276 (276 + 1)
+#define M278 (278 + 1)
+#define M280 (280 + 1)
+#define M282 (282 + 1)
+#define M284 (284 + 1)
+#define M286 (286 + 1)
+#define M288 (288 + 1)
+#define M290 (290 + 1)
+#define M292 (292 + 1)
+#define M294 (294 + 1)
+#define M296 (296 + 1)
+#define M298 (298 + 1)
+#define M300 (300 + 1)
+#define M302 (302 + 1)
+#define M304 (304 + 1)
+#define M306 (306 + 1)
+#define M308 (308 + 1)
+#define M310 (310 + 1)
+#define M312 (312 + 1)
+#define M314 (314 + 1)
+#define M316 (316 + 1)
+#define M318 (318 + 1)
+#define M320 (320 + 1)
+#define M322 (322 + 1)
+#define M324 (324 + 1)
+#define M326 (326 + 1)
+#define M328 (328 + 1)
+#define M330 (330 + 1)
+#define M332 (332 + 1)
+#define M334 (334 + 1)
+#define M336 (336 + 1)
+#define M338 (338 + 1)
+#define M340 (340 + 1)
+#define M342 (342 + 1)
+#define M344 (344 + 1)
+#define M346 (346 + 1)
+#define M348 (348 + 1)
+#define M350 (350 + 1)
+#define M352 (352 + 1)
+#define M354 (354 + 1)
+#define M356 (356 + 1)
+#define M358 (358 + 1)
+#define M360 (360 + 1)
+#define M362 (362 + 1)
+#define M364 (364 + 1)
+#define M366 (366 + 1)
+#define M368 (368 + 1)
+#define M370 (370 + 1)
+#define M372 (372 + 1)
+#define M374 (374 + 1)
+#define M376 (376 + 1)
+#define M378 (378 + 1)
+#define M380 (380 + 1)
+#define M382 (382 + 1)
+#define M384 (384 + 1)
+#define M386 (386 + 1)
+#define M388 (388 + 1)
+#define M390 (390 + 1)
+#define M392 (392 + 1)
+#define M394 (394 + 1)
+#define M396 (396 + 1)
+#define M398 (398 + 1)
+int b0 = M0 + M1;
+int b20 = M20 + M21;
+int b40 = M40 + M41;
+int b60 = M60 + M61;
+int b80 = M80 + M81;
+int b100 = M100 + M101;
+int b120 = M120 + M121;
+int b140 = M140 + M141;
+int b160 = M160 + M161;
+int b180 = M180 + M181;
+int b200 = M200 + M201;
+int b220 = M220 + M221;
+int b240 = M240 + M241;
+int b260 = M260 + M261;
+int b280 = M280 + M281;
+int b300 = M300 + M301;
+int b320 = M320 + M321;
+int b340 = M340 + M341;
+int b360 = M360 + M361;
+int b380 = M380 + M381;
+#ifdef M0
+int c0;
+#endif
+#ifdef M50
+int c50;
+#endif
+#ifdef M100
+int c100;
+#endif
+#ifdef M150
+int c150;
+#endif
+#ifdef M200
+int c200;
+#endif
+#ifdef M250
+int c250;
+#endif
+#ifdef M300
+int c300;
+#endif
+#ifdef M350
+int c350;
+#endif
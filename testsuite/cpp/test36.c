@@ -0,0 +1,21 @@
+/* The same conditions evaluated repeatedly with varying values of the
+   involved macros.  */
+#define VAL 1
+#include "test36.h"
+#undef VAL
+#define VAL 2
+#include "test36.h"
+#undef VAL
+#define VAL 3
+#include "test36.h"
+#define OTHER 4
+#include "test36.h"
+#undef VAL
+#define VAL 1
+#include "test36.h"
+#undef VAL
+#define VAL (1 + 2)
+#include "test36.h"
+#undef VAL
+#define VAL 3
+#include "test36.h"
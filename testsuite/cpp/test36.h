@@ -0,0 +1,9 @@
+#if VAL == 1
+int one;
+#elif VAL == 2
+int two;
+#elif defined(OTHER) && OTHER > VAL
+int other;
+#else
+int neither;
+#endif
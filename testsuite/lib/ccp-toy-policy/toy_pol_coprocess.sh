@@ -0,0 +1,11 @@
+#!/bin/sh
+
+# Persistent mode wrapper: answer each query line read from stdin by
+# invoking the one-shot toy policy command given as argument.
+pol="$1"
+
+while read -r query; do
+    eval "set -- $query"
+    "$pol" "$@" || exit $?
+    echo "END"
+done
@@ -0,0 +1,203 @@
+/*
+ * Policy plugin implementing the same name based toy policy as the
+ * toy_pol_*.sh policy commands.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "klp_ccp_policy_plugin.h"
+
+static char *new_name_buf;
+
+static void report_error(const struct klp_ccp_pol_reporter *r,
+			 const char *msg)
+{
+  struct klp_ccp_pol_str s = { msg, strlen(msg) };
+  r->error(r->ctx, s);
+}
+
+static int has_prefix(struct klp_ccp_pol_str s, size_t off, const char *p)
+{
+  const size_t len = strlen(p);
+  return s.len >= off + len && !memcmp(s.s + off, p, len);
+}
+
+/* Matches "p[use]_" at offset off. */
+static int is_pspec(struct klp_ccp_pol_str s, size_t off)
+{
+  return (s.len >= off + 3 && s.s[off] == 'p' &&
+	  s.s[off + 1] && strchr("use", s.s[off + 1]) &&
+	  s.s[off + 2] == '_');
+}
+
+/*
+ * Matches "e[use]p?r?_" at offset off and returns its length
+ * excluding the trailing '_', zero otherwise.
+ */
+static size_t espec_len(struct klp_ccp_pol_str s, size_t off)
+{
+  size_t j = off;
+
+  if (s.len < j + 2 || s.s[j] != 'e' || !s.s[j + 1] ||
+      !strchr("use", s.s[j + 1]))
+    return 0;
+  j += 2;
+  if (j < s.len && s.s[j] == 'p')
+    ++j;
+  if (j < s.len && s.s[j] == 'r')
+    ++j;
+  if (j == s.len || s.s[j] != '_')
+    return 0;
+  return j - off;
+}
+
+static enum klp_ccp_pol_linkage_change lc_from_spec(const char spec)
+{
+  switch (spec) {
+  case 's':
+    return KLP_CCP_POL_MAKE_INTERNAL;
+
+  case 'e':
+    return KLP_CCP_POL_MAKE_EXTERNAL;
+  }
+
+  return KLP_CCP_POL_KEEP_LINKAGE;
+}
+
+static struct klp_ccp_pol_str make_name(const struct klp_ccp_pol_reporter *r,
+					const char *prefix,
+					struct klp_ccp_pol_str name,
+					unsigned int retries)
+{
+  const size_t len = strlen(prefix) + name.len + 16;
+  struct klp_ccp_pol_str s = { NULL, 0 };
+  char *buf;
+  int n;
+
+  buf = realloc(new_name_buf, len);
+  if (!buf) {
+    report_error(r, "out of memory");
+    return s;
+  }
+  new_name_buf = buf;
+
+  if (retries) {
+    n = snprintf(buf, len, "%s%.*s%u", prefix, (int)name.len, name.s,
+		 retries);
+  } else {
+    n = snprintf(buf, len, "%s%.*s", prefix, (int)name.len, name.s);
+  }
+
+  s.s = buf;
+  s.len = n;
+  return s;
+}
+
+static int is_patched(const struct klp_ccp_pol_reporter *r,
+		      struct klp_ccp_pol_str fun)
+{
+  size_t j;
+
+  for (j = 0; j < fun.len; ++j) {
+    if (is_pspec(fun, j))
+      return 1;
+  }
+  return 0;
+}
+
+static int may_include_header(const struct klp_ccp_pol_reporter *r,
+			      struct klp_ccp_pol_str header,
+			      int is_pre_include)
+{
+  size_t base = header.len;
+  size_t j;
+
+  while (base && header.s[base - 1] != '/')
+    --base;
+
+  for (j = base; j < header.len; ++j) {
+    if (has_prefix(header, j, "internal"))
+      return 0;
+  }
+  return 1;
+}
+
+static int can_externalize_fun(const struct klp_ccp_pol_reporter *r,
+			       struct klp_ccp_pol_str fun,
+			       enum klp_ccp_pol_linkage linkage,
+			       const struct klp_ccp_pol_src_loc *def_loc)
+{
+  return espec_len(fun, is_pspec(fun, 0) ? 3 : 0) != 0;
+}
+
+static int shall_externalize_fun(const struct klp_ccp_pol_reporter *r,
+				 struct klp_ccp_pol_str fun,
+				 int from_header)
+{
+  return !from_header;
+}
+
+static int shall_externalize_obj(const struct klp_ccp_pol_reporter *r,
+				 struct klp_ccp_pol_str obj)
+{
+  return espec_len(obj, 0) != 0;
+}
+
+static void modify_externalized_sym(const struct klp_ccp_pol_reporter *r,
+				    enum klp_ccp_pol_sym_kind kind,
+				    struct klp_ccp_pol_str name,
+				    unsigned int retries,
+				    struct klp_ccp_pol_sym_mod *mod)
+{
+  size_t off = 0;
+  size_t len;
+
+  if (kind == KLP_CCP_POL_SYM_FUNCTION && is_pspec(name, 0))
+    off = 3;
+
+  len = espec_len(name, off);
+  if (!len) {
+    report_error(r, "logic error: symbol should be externalizable");
+    return;
+  }
+
+  if (memchr(name.s + off, 'r', len))
+    mod->new_name = make_name(r, "klpe_", name, retries);
+  mod->new_linkage = lc_from_spec(name.s[off + 1]);
+  mod->make_pointer = memchr(name.s + off, 'p', len) != NULL;
+}
+
+static void modify_patched_fun_sym(const struct klp_ccp_pol_reporter *r,
+				   struct klp_ccp_pol_str fun,
+				   unsigned int retries,
+				   struct klp_ccp_pol_sym_mod *mod)
+{
+  if (!is_pspec(fun, 0)) {
+    report_error(r, "logic error: function should be patched");
+    return;
+  }
+
+  mod->new_name = make_name(r, "klpp_", fun, retries);
+  mod->new_linkage = lc_from_spec(fun.s[1]);
+}
+
+static void rename_rewritten_fun(const struct klp_ccp_pol_reporter *r,
+				 struct klp_ccp_pol_str fun,
+				 unsigned int retries,
+				 struct klp_ccp_pol_str *new_name)
+{
+  *new_name = make_name(r, "klpr_", fun, retries);
+}
+
+const struct klp_ccp_pol_plugin_ops klp_ccp_pol_plugin_ops = {
+  .abi_version = KLP_CCP_POL_PLUGIN_ABI_VERSION,
+  .is_patched = is_patched,
+  .may_include_header = may_include_header,
+  .can_externalize_fun = can_externalize_fun,
+  .shall_externalize_fun = shall_externalize_fun,
+  .shall_externalize_obj = shall_externalize_obj,
+  .modify_externalized_sym = modify_externalized_sym,
+  .modify_patched_fun_sym = modify_patched_fun_sym,
+  .rename_rewritten_fun = rename_rewritten_fun,
+};
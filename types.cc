@@ -142,7 +142,9 @@ type::type(const qualifiers &qs)
   : _qs(qs)
 {}
 
-type::type(const type&) = default;
+type::type(const type &t)
+  : std::enable_shared_from_this<type>(), _qs(t._qs)
+{}
 
 type::~type() noexcept = default;
 
@@ -233,9 +235,7 @@ bool type::is_compatible_with(const architecture&, const builtin_func_type&,
 
 std::shared_ptr<const type> type::amend_qualifiers(const qualifiers &qs) const
 {
-  std::shared_ptr<type> new_t(this->_clone());
-  new_t->_amend_qualifiers(qs);
-  return new_t;
+  return _get_amended(qs, &type::_clone);
 }
 
 std::shared_ptr<const type> type::strip_qualifiers() const
@@ -243,6 +243,27 @@ std::shared_ptr<const type> type::strip_qualifiers() const
   return _strip_qualifiers(_self_ptr<type>(), &type::_clone);
 }
 
+template<typename self_type>
+std::shared_ptr<const self_type>
+type::_get_amended(const qualifiers &qs,
+		   self_type* (self_type::*clone)() const) const
+{
+  // Qualifiers already present don't change anything. Note that
+  // array and function types never have any qualifiers of their own.
+  if (qs.is_subset_of(_qs))
+    return _self_ptr<self_type>();
+
+  for (const auto &a : _amended) {
+    if (a.first == qs)
+      return std::dynamic_pointer_cast<const self_type>(a.second);
+  }
+
+  std::shared_ptr<self_type> new_t{(_self_ptr<self_type>().get()->*clone)()};
+  static_cast<type&>(*new_t)._amend_qualifiers(qs);
+  _amended.emplace_back(qs, new_t);
+  return new_t;
+}
+
 void type::_amend_qualifiers(const qualifiers &qs)
 {
   _qs.add(qs);
@@ -266,7 +287,9 @@ addressable_type::addressable_type(const alignment &user_align)
   : _user_align(user_align)
 {}
 
-addressable_type::addressable_type(const addressable_type&) = default;
+addressable_type::addressable_type(const addressable_type &t)
+  : type(t), _user_align(t._user_align)
+{}
 
 addressable_type::~addressable_type() noexcept = default;
 
@@ -274,17 +297,25 @@ std::shared_ptr<const pointer_type>
 addressable_type::derive_pointer(const qualifiers &qs,
 				 const alignment &user_align) const
 {
+  const bool is_unqualified = !qs.any() && !user_align.is_set();
+  if (is_unqualified) {
+    std::shared_ptr<const pointer_type> p = _unqualified_pointer.lock();
+    if (p)
+      return p;
+  }
+
   auto self = _self_ptr<addressable_type>();
-  return (std::shared_ptr<const pointer_type>
-	  (new pointer_type(std::move(self), qs, user_align)));
+  std::shared_ptr<const pointer_type> p
+    (new pointer_type(std::move(self), qs, user_align));
+  if (is_unqualified)
+    _unqualified_pointer = p;
+  return p;
 }
 
 std::shared_ptr<const addressable_type>
 addressable_type::amend_qualifiers(const qualifiers &qs) const
 {
-  std::shared_ptr<addressable_type> new_t(this->_clone());
-  new_t->_amend_qualifiers(qs);
-  return new_t;
+  return _get_amended(qs, &addressable_type::_clone);
 }
 
 std::shared_ptr<const addressable_type>
@@ -407,9 +438,7 @@ object_type::~object_type() noexcept = default;
 std::shared_ptr<const object_type>
 object_type::amend_qualifiers(const qualifiers &qs) const
 {
-  std::shared_ptr<object_type> new_t(this->_clone());
-  new_t->_amend_qualifiers(qs);
-  return new_t;
+  return _get_amended(qs, &object_type::_clone);
 }
 
 std::shared_ptr<const array_type>
@@ -1147,6 +1176,14 @@ bool pointer_type::is_compatible_with(const architecture &arch,
   if (!ignore_qualifiers && (this->get_qualifiers() != t.get_qualifiers()))
     return false;
 
+  // Derived types get shared, so pointers to the very same type are
+  // common. Builtin function types aren't compatible with anything,
+  // not even with themselves.
+  if (_pointed_to_type == t._pointed_to_type &&
+      (_pointed_to_type->get_type_id() != type_id::tid_builtin_func)) {
+    return true;
+  }
+
   return _pointed_to_type->is_compatible_with(arch, *t._pointed_to_type, true);
 }
 
@@ -1322,59 +1359,66 @@ struct_or_union_content::struct_or_union_content()
 void struct_or_union_content::add_member(member &&m)
 {
   _members.emplace_back(std::move(m));
+  if (_index)
+    _index_member(_members.size() - 1);
 }
 
 struct_or_union_content::lookup_result
 struct_or_union_content::lookup(const std::string &name) const
 {
-  typedef std::pair<const_member_iterator, const_member_iterator> stack_entry;
-  std::vector<stack_entry> stack;
+  const _index_type &index = _get_index();
+  const auto it_path = index.find(name);
+  if (it_path == index.end())
+    return lookup_result{};
+
+  lookup_result r;
+  const struct_or_union_content *souc = this;
+  for (const auto pos : it_path->second) {
+    const const_member_iterator it = souc->_members.begin() + pos;
+    r.push_back(it);
+    if (it->is_unnamed_sou())
+      souc = it->get_sou_type()->get_content();
+  }
 
-  const_member_iterator it = _members.begin();
-  const_member_iterator it_end = _members.end();
+  return r;
+}
 
-  while(it != it_end) {
-    while (it != it_end && it->is_unnamed_sou()) {
-      // Enter anonymous struct or union.
-      const struct_or_union_content * const souc =
-	it->get_sou_type()->get_content();
+const struct_or_union_content::_index_type&
+struct_or_union_content::_get_index() const
+{
+  if (!_index) {
+    _index.reset(new _index_type{});
+    for (std::size_t i = 0; i < _members.size(); ++i)
+      _index_member(i);
+  }
 
-      if (souc && !souc->_members.empty()) {
-	stack.push_back(std::make_pair(it, it_end));
-	it = souc->_members.begin();
-	it_end = souc->_members.end();
-      } else {
-	// Skip empty, anonymous struct or union.
-	++it;
-      }
-    }
+  return *_index;
+}
 
-    if (it != it_end) {
-      assert(!it->is_unnamed_sou());
-
-      if (it->get_name() == name) {
-	// Found it, return the full path to the member.
-	lookup_result r;
-	std::transform(stack.begin(), stack.end(), std::back_inserter(r),
-		       [&](const stack_entry &se) {
-			 return se.first;
-			});
-	r.push_back(it);
-	return r;
-      }
+void struct_or_union_content::_index_member(const std::size_t pos) const
+{
+  // Only the first of several equally named members is reachable,
+  // so never overwrite existing entries.
+  const member &m = _members[pos];
+  if (!m.is_unnamed_sou()) {
+    _index->emplace(m.get_name(), std::vector<std::size_t>{pos});
+    return;
+  }
 
-      ++it;
-    }
+  const struct_or_union_content * const souc = m.get_sou_type()->get_content();
+  if (!souc || souc->_members.empty())
+    return;
 
-    // Possibly go up the anonymous struct/union stack.
-    while(it == it_end && !stack.empty()) {
-      const stack_entry se = stack.back();
-      stack.pop_back();
-      it = se.first + 1;
-      it_end = se.second;
-    }
+  for (const auto &e : souc->_get_index()) {
+    if (_index->count(e.first))
+      continue;
+
+    std::vector<std::size_t> path;
+    path.reserve(e.second.size() + 1);
+    path.push_back(pos);
+    path.insert(path.end(), e.second.cbegin(), e.second.cend());
+    _index->emplace(e.first, std::move(path));
   }
-  return lookup_result{};
 }
 
 void struct_or_union_content::
@@ -1965,6 +2009,7 @@ add_member(const ast::enumerator &e, const std::string &name,
 {
   assert(!_underlying_type);
   assert(!lookup(name));
+  _index.emplace(name, _members.size());
   _members.emplace_back(e, name, initial_type, value);
 }
 
@@ -2003,12 +2048,9 @@ void enum_content::add_member(const ast::enumerator &e, const std::string &name,
 const enum_content::member* enum_content::lookup(const std::string &name)
   const noexcept
 {
-  auto it = std::find_if(_members.begin(), _members.end(),
-			 [&name](const member &m) {
-			   return m.get_name() == name;
-			 });
-  if (it != _members.end())
-    return &*it;
+  const auto it = _index.find(name);
+  if (it != _index.end())
+    return &_members[it->second];
 
   return nullptr;
 }
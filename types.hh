@@ -23,6 +23,7 @@
 #include <vector>
 #include <memory>
 #include <functional>
+#include <unordered_map>
 #include "mp_arithmetic.hh"
 #include "target_int.hh"
 #include "builtins.hh"
@@ -222,12 +223,23 @@ namespace klp
 	  return std::dynamic_pointer_cast<const self_type>(shared_from_this());
 	}
 
+	template<typename self_type>
+	std::shared_ptr<const self_type>
+	_get_amended(const qualifiers &qs,
+		     self_type* (self_type::*clone)() const) const;
+
 	virtual void _amend_qualifiers(const qualifiers &qs);
 
       private:
 	virtual type* _clone() const = 0;
 
 	qualifiers _qs;
+
+	// The results of previous amend_qualifiers() invocations. These
+	// are immutable and get handed out again for the same
+	// qualifiers. Not copied along with the type.
+	mutable std::vector<std::pair<qualifiers, std::shared_ptr<const type>>>
+		_amended;
       };
 
       class addressable_type : public virtual type
@@ -304,6 +316,10 @@ namespace klp
 			     const pointer_type& next_type) const;
 
 	alignment _user_align;
+
+	// Unqualified pointers to this type are requested often, for
+	// example upon each array or function to pointer conversion.
+	mutable std::weak_ptr<const pointer_type> _unqualified_pointer;
       };
 
       class function_type : public addressable_type
@@ -783,7 +799,18 @@ namespace klp
 	mpa::limbs::size_type get_alignment() const noexcept;
 
       private:
+	// Maps the names of all members, including those reachable
+	// through unnamed structs or unions, to their path of positions
+	// in the respective _members. Built on first lookup() and kept
+	// up to date by add_member() afterwards.
+	typedef std::unordered_map<std::string, std::vector<std::size_t>>
+		_index_type;
+
+	const _index_type& _get_index() const;
+	void _index_member(const std::size_t pos) const;
+
 	std::vector<member> _members;
+	mutable std::unique_ptr<_index_type> _index;
 	mpa::limbs::size_type _align_ffs;
 	mpa::limbs _size;
 	bool _is_size_constant;
@@ -1172,6 +1199,7 @@ namespace klp
 
       private:
 	std::vector<member> _members;
+	std::unordered_map<std::string, std::size_t> _index;
 	std::shared_ptr<const std_int_type> _underlying_type;
       };
 
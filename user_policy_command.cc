@@ -22,14 +22,69 @@
 #include <iostream>
 #include <cstdlib>
 #include <algorithm>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/wait.h>
 #include <sys/select.h>
+#include <sys/socket.h>
 #include "user_policy_command.hh"
+#include "policy_answer_cache.hh"
 
 using namespace klp::ccp;
 
-user_policy_command::user_policy_command(const std::string &cmd)
+class user_policy_command::_coprocess
+{
+public:
+  _coprocess(const pid_t _pid, const int _stdin_fd, const int _stdout_fd,
+	     const int _stderr_fd) noexcept;
+
+  ~_coprocess() noexcept;
+
+  pid_t pid;
+  int stdin_fd;
+  int stdout_fd;
+  int stderr_fd;
+  std::vector<char> stdout_buf;
+
+  // Number of queries sent, but not answered yet.
+  std::size_t n_pending;
+
+  // Set after a protocol failure, in which case the co-process gets
+  // killed and restarted on next use.
+  bool broken;
+};
+
+user_policy_command::_coprocess::_coprocess(const pid_t _pid,
+					    const int _stdin_fd,
+					    const int _stdout_fd,
+					    const int _stderr_fd) noexcept
+  : pid(_pid), stdin_fd(_stdin_fd), stdout_fd(_stdout_fd),
+    stderr_fd(_stderr_fd), n_pending(0), broken(false)
+{}
+
+user_policy_command::_coprocess::~_coprocess() noexcept
+{
+  // Closing stdin asks a well-behaved co-process to terminate.
+  close(stdin_fd);
+  if (pid != -1) {
+    if (broken || n_pending)
+      kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+  }
+
+  close(stdout_fd);
+  if (stderr_fd != -1)
+    close(stderr_fd);
+}
+
+
+user_policy_command::user_policy_command(const std::string &cmd,
+					 const bool persistent,
+					 const unsigned int max_jobs,
+					 policy_answer_cache * const cache)
+  : _persistent(persistent),
+    _max_jobs(!max_jobs ? 1 : (max_jobs < _MAX_JOBS ? max_jobs : _MAX_JOBS)),
+    _cache(cache)
 {
   char in_quotation = '\0';
   bool last_was_escape = false;
@@ -119,6 +174,11 @@ user_policy_command::user_policy_command(const std::string &cmd)
     throw cmd_parse_except("no command given");
 }
 
+user_policy_command::user_policy_command(user_policy_command &&c) noexcept
+  = default;
+
+user_policy_command::~user_policy_command() noexcept = default;
+
 user_policy_command::instance
 user_policy_command::execute(const std::vector<std::string> &extra_args,
 			     char *envp[], std::regex &&re_result) const
@@ -130,14 +190,83 @@ user_policy_command::execute(const std::vector<std::string> &extra_args,
   for (const auto &arg : extra_args)
     argv.push_back(arg);
 
+  if (_cache) {
+    std::string answer;
+    if (_cache->lookup(argv, answer)) {
+      return instance{std::move(answer), std::move(argv),
+		      std::move(re_result)};
+    }
+  }
+
+  // Arguments containing newlines can't be sent in a single query
+  // line, fall back to a one-shot invocation for these.
+  if (_persistent &&
+      std::none_of(extra_args.cbegin(), extra_args.cend(),
+		   [](const std::string &arg) {
+		     return arg.find('\n') != std::string::npos;
+		   })) {
+    std::string query;
+    bool first = true;
+    for (const auto &arg : extra_args) {
+      if (!first)
+	query += ' ';
+      else
+	first = false;
+
+      if (arg.empty() || arg.find_first_of("\\\"' \t") != std::string::npos)
+	query += instance::_quote_str(arg);
+      else
+	query += arg;
+    }
+    query += '\n';
+
+    _coprocess &cp = _get_coprocess(envp);
+    for (std::string::size_type sent = 0; sent < query.size();) {
+      const ssize_t r = send(cp.stdin_fd, query.data() + sent,
+			     query.size() - sent, MSG_NOSIGNAL);
+      if (r < 0) {
+	if (errno == EINTR)
+	  continue;
+
+	cp.broken = true;
+	throw std::system_error{
+		errno, std::system_category(),
+		"failed to send query to \"" + _args[0] + "\""
+	      };
+      }
+      sent += r;
+    }
+
+    ++cp.n_pending;
+    instance i{cp, std::move(argv), std::move(re_result)};
+    i._cache = _cache;
+    return i;
+  }
+
+  int stdout_fd;
+  int stderr_fd;
+  const pid_t pid = _spawn(argv, envp, -1, stdout_fd, stderr_fd);
+
+  instance i{pid, stdout_fd, stderr_fd, std::move(argv),
+	     std::move(re_result)};
+  i._cache = _cache;
+  return i;
+}
+
+pid_t user_policy_command::_spawn(const std::vector<std::string> &argv,
+				  char *envp[], const int stdin_fd,
+				  int &stdout_fd, int &stderr_fd) const
+{
   std::vector<char *> c_argv;
   c_argv.reserve(argv.size() + 1);
   for (const auto &arg : argv)
     c_argv.push_back(const_cast<char*>(arg.c_str()));
   c_argv.push_back(nullptr);
 
+  // Don't leak the pipes into other policy commands, a persistent
+  // co-process would not see EOF on its stdin otherwise.
   int stdout_pipe[2];
-  if (pipe(stdout_pipe)) {
+  if (pipe2(stdout_pipe, O_CLOEXEC)) {
     throw std::system_error{
 	    errno, std::system_category(),
 	    "failed to created pipe for \"" + _args[0] + "\""
@@ -145,7 +274,7 @@ user_policy_command::execute(const std::vector<std::string> &extra_args,
   }
 
   int stderr_pipe[2];
-  if (pipe(stderr_pipe)) {
+  if (pipe2(stderr_pipe, O_CLOEXEC)) {
     close(stdout_pipe[0]);
     close(stdout_pipe[1]);
     throw std::system_error{
@@ -196,6 +325,19 @@ user_policy_command::execute(const std::vector<std::string> &extra_args,
     }
     close(stdout_pipe[1]);
 
+    if (stdin_fd != -1) {
+      if (dup2(stdin_fd, 0) < 0) {
+	std::cerr
+	  << (std::system_error{
+	       errno, std::system_category(),
+	       "failed to redirect stdin for \"" + _args[0] + "\""
+	      }).what()
+	  << std::endl;
+	std::abort();
+      }
+      close(stdin_fd);
+    }
+
     execve(c_argv[0], &c_argv[0], envp);
     std::cerr
       << (std::system_error{
@@ -209,11 +351,114 @@ user_policy_command::execute(const std::vector<std::string> &extra_args,
     close(stdout_pipe[1]);
     close(stderr_pipe[1]);
 
-    return instance{pid, stdout_pipe[0], stderr_pipe[0], std::move(argv),
-		    std::move(re_result)};
+    stdout_fd = stdout_pipe[0];
+    stderr_fd = stderr_pipe[0];
+    return pid;
   }
 }
 
+std::vector<user_policy_command::instance>
+user_policy_command::
+execute_batch(const std::vector<std::vector<std::string>> &queries,
+	      char *envp[], const std::regex &re_result) const
+{
+  std::vector<instance> instances;
+  instances.reserve(queries.size());
+
+  if (_persistent) {
+    // Bound the number of outstanding queries so that neither side
+    // can ever block on a full pipe.
+    std::size_t n_waited = 0;
+    for (const auto &q : queries) {
+      instances.push_back(execute(q, envp, std::regex{re_result}));
+      if (instances.size() - n_waited == _MAX_PIPELINED_QUERIES)
+	instances[n_waited++].wait();
+    }
+
+    while (n_waited < instances.size())
+      instances[n_waited++].wait();
+
+    return instances;
+  }
+
+  // Keep up to _max_jobs one-shot invocations running at a time and
+  // reap them in whatever order they finish.
+  std::vector<std::size_t> running;
+  while (instances.size() < queries.size() || !running.empty()) {
+    while (instances.size() < queries.size() && running.size() < _max_jobs) {
+      instances.push_back(execute(queries[instances.size()], envp,
+				  std::regex{re_result}));
+      if (instances.back()._from_cache)
+	instances.back().wait();
+      else
+	running.push_back(instances.size() - 1);
+    }
+
+    if (running.empty())
+      continue;
+
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    int nfds = 0;
+    for (const auto j : running)
+      nfds = instances[j]._add_output_fds(readfds, nfds);
+
+    if (select(nfds, &readfds, nullptr, nullptr, nullptr) < 0) {
+      if (errno == EINTR)
+	continue;
+
+      throw std::system_error{
+	      errno, std::system_category(),
+	      "failed to wait for output from \"" + _args[0] + "\""
+	    };
+    }
+
+    for (auto it = running.begin(); it != running.end();) {
+      instance &i = instances[*it];
+      i._read_output(readfds);
+      if (i._output_done()) {
+	i._reap();
+	it = running.erase(it);
+      } else {
+	++it;
+      }
+    }
+  }
+
+  return instances;
+}
+
+user_policy_command::_coprocess&
+user_policy_command::_get_coprocess(char *envp[]) const
+{
+  if (_cp && !_cp->broken)
+    return *_cp;
+  _cp.reset();
+
+  int stdin_socks[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, stdin_socks)) {
+    throw std::system_error{
+	    errno, std::system_category(),
+	    "failed to create socket pair for \"" + _args[0] + "\""
+	  };
+  }
+
+  int stdout_fd;
+  int stderr_fd;
+  pid_t pid;
+  try {
+    pid = _spawn(_args, envp, stdin_socks[1], stdout_fd, stderr_fd);
+  } catch (...) {
+    close(stdin_socks[0]);
+    close(stdin_socks[1]);
+    throw;
+  }
+  close(stdin_socks[1]);
+
+  _cp.reset(new _coprocess{pid, stdin_socks[0], stdout_fd, stderr_fd});
+  return *_cp;
+}
+
 
 user_policy_command::cmd_parse_except::cmd_parse_except(const char * const what)
   : _what(what)
@@ -244,12 +489,31 @@ user_policy_command::instance::instance(const pid_t pid,
 					const int stderr_fd,
 					std::vector<std::string> &&argv,
 					std::regex &&re_result) noexcept
-  : _pid(pid), _stdout_fd(stdout_fd), _stderr_fd(stderr_fd),
+  : _pid(pid), _stdout_fd(stdout_fd), _stderr_fd(stderr_fd), _cp(nullptr),
+    _from_cache(false), _cache(nullptr),
+    _argv(std::move(argv)), _re_result(std::move(re_result))
+{}
+
+user_policy_command::instance::instance(_coprocess &cp,
+					std::vector<std::string> &&argv,
+					std::regex &&re_result) noexcept
+  : _pid(-1), _stdout_fd(-1), _stderr_fd(-1), _cp(&cp),
+    _from_cache(false), _cache(nullptr),
     _argv(std::move(argv)), _re_result(std::move(re_result))
 {}
 
+user_policy_command::instance::instance(std::string &&cached_answer,
+					std::vector<std::string> &&argv,
+					std::regex &&re_result)
+  : _pid(-1), _stdout_fd(-1), _stderr_fd(-1), _cp(nullptr),
+    _from_cache(true), _cache(nullptr),
+    _argv(std::move(argv)), _re_result(std::move(re_result)),
+    _stdout_buf(cached_answer.begin(), cached_answer.end())
+{}
+
 user_policy_command::instance::instance(instance &&i) noexcept
   : _pid(i._pid), _stdout_fd(i._stdout_fd), _stderr_fd(i._stderr_fd),
+    _cp(i._cp), _from_cache(i._from_cache), _cache(i._cache),
     _argv(std::move(i._argv)), _re_result(std::move(i._re_result)),
     _stdout_buf(std::move(i._stdout_buf)), _result(std::move(i._result)),
     _matched_result(std::move(i._matched_result)),
@@ -259,10 +523,15 @@ user_policy_command::instance::instance(instance &&i) noexcept
   i._pid = -1;
   i._stdout_fd = -1;
   i._stderr_fd = -1;
+  i._cp = nullptr;
 }
 
 user_policy_command::instance::~instance() noexcept
 {
+  // An unread answer would get out of sync with subsequent queries.
+  if (_cp)
+    _cp->broken = true;
+
   if (_pid != -1) {
     kill(_pid, SIGKILL);
     waitpid(_pid, nullptr, 0);
@@ -277,45 +546,227 @@ user_policy_command::instance::~instance() noexcept
 
 void user_policy_command::instance::wait()
 {
+  if (_from_cache) {
+    _buffer_type buf;
+    buf.swap(_stdout_buf);
+    _process_stdout(std::move(buf));
+    _process_stdout(_buffer_type{});
+    _from_cache = false;
+    _check_result();
+    return;
+  }
+
+  if (_cp) {
+    _wait_coprocess();
+    return;
+  }
+
   assert(_pid != -1);
 
-  while (_stdout_fd != -1 || _stdout_fd != -1) {
-    int nfds = 0;
+  while (!_output_done()) {
     fd_set readfds;
     FD_ZERO(&readfds);
+    const int nfds = _add_output_fds(readfds, 0);
 
-    if (_stdout_fd != -1) {
-      if (_stdout_fd > nfds)
-	nfds = _stdout_fd;
-      FD_SET(_stdout_fd, &readfds);
+    if (select(nfds, &readfds, nullptr, nullptr, nullptr) < 0) {
+      if (errno == EINTR)
+	continue;
+
+      throw std::system_error{
+	      errno, std::system_category(),
+	      "failed to wait for output from \"" + _argv[0] + "\""
+	    };
+    }
+
+    _read_output(readfds);
+  }
+
+  _reap();
+}
+
+int user_policy_command::instance::_add_output_fds(fd_set &readfds,
+						   int nfds) const noexcept
+{
+  if (_stdout_fd != -1) {
+    if (_stdout_fd >= nfds)
+      nfds = _stdout_fd + 1;
+    FD_SET(_stdout_fd, &readfds);
+  }
+  if (_stderr_fd != -1) {
+    if (_stderr_fd >= nfds)
+      nfds = _stderr_fd + 1;
+    FD_SET(_stderr_fd, &readfds);
+  }
+
+  return nfds;
+}
+
+void user_policy_command::instance::_read_output(const fd_set &readfds)
+{
+  if (_stdout_fd != -1 && FD_ISSET(_stdout_fd, &readfds)) {
+    _buffer_type buf;
+    buf.resize(4096);
+    ssize_t r = read(_stdout_fd, &buf[0], buf.size());
+    if (r > 0) {
+      buf.resize(r);
+      buf.shrink_to_fit();
+
+    } else if (!r) {
+      close(_stdout_fd);
+      _stdout_fd = -1;
+      buf.clear();
+      buf.shrink_to_fit();
+
+    } else {
+      throw std::system_error{
+	      errno, std::system_category(),
+	      "failed to read output from \"" + _argv[0] + "\""
+	    };
+    }
+
+    _process_stdout(std::move(buf));
+  }
+
+  if (_stderr_fd != -1 && FD_ISSET(_stderr_fd, &readfds)) {
+    _buffer_type buf;
+    buf.resize(4096);
+    ssize_t r = read(_stderr_fd, &buf[0], buf.size());
+    if (r > 0) {
+      buf.resize(r);
+      buf.shrink_to_fit();
+
+    } else if (!r) {
+      close(_stderr_fd);
+      _stderr_fd = -1;
+      buf.clear();
+      buf.shrink_to_fit();
+
+    } else {
+      throw std::system_error{
+	      errno, std::system_category(),
+	      "failed to read output from \"" + _argv[0] + "\""
+	    };
+    }
+
+    _process_stderr(std::move(buf));
+  }
+}
+
+void user_policy_command::instance::_reap()
+{
+  int status;
+  if (waitpid(_pid, &status, 0) == -1) {
+    throw std::system_error{
+	    errno, std::system_category(),
+	    "failed to wait for \"" + _argv[0] + "\""
+	  };
+  }
+  _pid = -1;
+
+  _check_exit_status(status);
+  _check_result();
+  _store_answer();
+}
+
+void user_policy_command::instance::_store_answer()
+{
+  // Answers with errors abort the live patch creation anyway, there's
+  // no point in caching them.
+  if (!_cache || !_errors.empty())
+    return;
+
+  std::string answer;
+  for (const auto &w : _warnings)
+    answer += "WARNING: " + w + '\n';
+  answer += "RESULT: " + _result + '\n';
+  _cache->insert(_argv, answer);
+}
+
+void user_policy_command::instance::_wait_coprocess()
+{
+  _coprocess &cp = *_cp;
+  _cp = nullptr;
+  // Not knowing where this answer ends, the co-process can't be
+  // reused if anything goes wrong.
+  const bool was_broken = cp.broken;
+  cp.broken = true;
+
+  bool end_seen = false;
+  while (true) {
+    _buffer_type::iterator line_begin = cp.stdout_buf.begin();
+    while (!end_seen) {
+      _buffer_type::iterator line_end =
+	std::find(line_begin, cp.stdout_buf.end(), '\n');
+      if (line_end == cp.stdout_buf.end())
+	break;
+
+      static const char sEND[] = "END";
+      _buffer_type::iterator end_begin = line_begin;
+      _buffer_type::iterator end_end = line_end;
+      const auto& f = std::use_facet<std::ctype<char>>(std::locale());
+      while (end_begin != end_end && f.is(std::ctype_base::blank, *end_begin))
+	++end_begin;
+      while (end_end != end_begin &&
+	     f.is(std::ctype_base::blank, *(end_end - 1))) {
+	--end_end;
+      }
+
+      if (end_end - end_begin == sizeof(sEND) - 1 &&
+	  std::equal(sEND, sEND + sizeof(sEND) - 1, end_begin)) {
+	end_seen = true;
+      } else {
+	_process_stdout_line(line_begin, line_end);
+      }
+      line_begin = line_end + 1;
     }
-    if (_stderr_fd != -1) {
-      if (_stderr_fd > nfds)
-	nfds = _stderr_fd;
-      FD_SET(_stderr_fd, &readfds);
+    cp.stdout_buf.erase(cp.stdout_buf.begin(), line_begin);
+
+    if (end_seen)
+      break;
+
+    int nfds = cp.stdout_fd;
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(cp.stdout_fd, &readfds);
+    if (cp.stderr_fd != -1) {
+      if (cp.stderr_fd > nfds)
+	nfds = cp.stderr_fd;
+      FD_SET(cp.stderr_fd, &readfds);
     }
     ++nfds;
 
     if (select(nfds, &readfds, nullptr, nullptr, nullptr) < 0) {
+      if (errno == EINTR)
+	continue;
+
       throw std::system_error{
 	      errno, std::system_category(),
 	      "failed to wait for output from \"" + _argv[0] + "\""
 	    };
     }
 
-    if (FD_ISSET(_stdout_fd, &readfds)) {
+    if (FD_ISSET(cp.stdout_fd, &readfds)) {
       _buffer_type buf;
       buf.resize(4096);
-      ssize_t r = read(_stdout_fd, &buf[0], buf.size());
+      ssize_t r = read(cp.stdout_fd, &buf[0], buf.size());
       if (r > 0) {
-	buf.resize(r);
-	buf.shrink_to_fit();
+	cp.stdout_buf.insert(cp.stdout_buf.end(), buf.begin(), buf.begin() + r);
 
       } else if (!r) {
-	close(_stdout_fd);
-	_stdout_fd = -1;
-	buf.clear();
-	buf.shrink_to_fit();
+	// The co-process terminated before answering the query.
+	int status;
+	if (waitpid(cp.pid, &status, 0) == -1) {
+	  throw std::system_error{
+		  errno, std::system_category(),
+		  "failed to wait for \"" + _argv[0] + "\""
+		};
+	}
+	cp.pid = -1;
+
+	_check_exit_status(status);
+	throw execution_except{
+		"command '" + _format_cmd() + "' terminated unexpectedly"
+	      };
 
       } else {
 	throw std::system_error{
@@ -323,24 +774,18 @@ void user_policy_command::instance::wait()
 		"failed to read output from \"" + _argv[0] + "\""
 	      };
       }
-
-      _process_stdout(std::move(buf));
     }
 
-    if (FD_ISSET(_stderr_fd, &readfds)) {
+    if (cp.stderr_fd != -1 && FD_ISSET(cp.stderr_fd, &readfds)) {
       _buffer_type buf;
       buf.resize(4096);
-      ssize_t r = read(_stderr_fd, &buf[0], buf.size());
+      ssize_t r = read(cp.stderr_fd, &buf[0], buf.size());
       if (r > 0) {
 	buf.resize(r);
-	buf.shrink_to_fit();
-
       } else if (!r) {
-	close(_stderr_fd);
-	_stderr_fd = -1;
+	close(cp.stderr_fd);
+	cp.stderr_fd = -1;
 	buf.clear();
-	buf.shrink_to_fit();
-
       } else {
 	throw std::system_error{
 		errno, std::system_category(),
@@ -352,15 +797,42 @@ void user_policy_command::instance::wait()
     }
   }
 
-  int status;
-  if (waitpid(_pid, &status, 0) == -1) {
-    throw std::system_error{
-	    errno, std::system_category(),
-	    "failed to wait for \"" + _argv[0] + "\""
-	  };
+  // Anything written to stderr before the "END" line is available by
+  // now, pick it up without blocking.
+  while (cp.stderr_fd != -1) {
+    fd_set readfds;
+    FD_ZERO(&readfds);
+    FD_SET(cp.stderr_fd, &readfds);
+    struct timeval timeout = { 0, 0 };
+    const int r = select(cp.stderr_fd + 1, &readfds, nullptr, nullptr,
+			 &timeout);
+    if (r < 0 && errno == EINTR)
+      continue;
+    else if (r <= 0)
+      break;
+
+    _buffer_type buf;
+    buf.resize(4096);
+    ssize_t n = read(cp.stderr_fd, &buf[0], buf.size());
+    if (n <= 0) {
+      close(cp.stderr_fd);
+      cp.stderr_fd = -1;
+      break;
+    }
+    buf.resize(n);
+    _process_stderr(std::move(buf));
   }
-  _pid = -1;
+  _process_stderr(_buffer_type{});
+
+  _check_result();
+  --cp.n_pending;
+  cp.broken = was_broken;
 
+  _store_answer();
+}
+
+void user_policy_command::instance::_check_exit_status(const int status)
+{
   if (WIFSIGNALED(status)) {
     const int signr = WTERMSIG(status);
 
@@ -390,7 +862,10 @@ void user_policy_command::instance::wait()
     assert(0);
     __builtin_unreachable();
   }
+}
 
+void user_policy_command::instance::_check_result()
+{
   if (!_stderr_output.empty()) {
     std::string msg =
       ("command '" + _format_cmd() +
@@ -415,7 +890,7 @@ void user_policy_command::instance::wait()
 const std::string& user_policy_command::instance::get_plain_result()
   const noexcept
 {
-  assert(_pid == -1);
+  assert(_pid == -1 && !_cp && !_from_cache);
   assert(!_matched_result.empty());
   return _result;
 }
@@ -423,7 +898,7 @@ const std::string& user_policy_command::instance::get_plain_result()
 const std::smatch& user_policy_command::instance::get_matched_result()
   const noexcept
 {
-  assert(_pid == -1);
+  assert(_pid == -1 && !_cp && !_from_cache);
   assert(!_matched_result.empty());
   return _matched_result;
 }
@@ -431,14 +906,14 @@ const std::smatch& user_policy_command::instance::get_matched_result()
 const std::vector<std::string>& user_policy_command::instance::get_warnings()
   const noexcept
 {
-  assert(_pid == -1);
+  assert(_pid == -1 && !_cp && !_from_cache);
   return _warnings;
 }
 
 const std::vector<std::string>& user_policy_command::instance::get_errors()
   const noexcept
 {
-  assert(_pid == -1);
+  assert(_pid == -1 && !_cp && !_from_cache);
   return _errors;
 }
 
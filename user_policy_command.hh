@@ -24,14 +24,21 @@
 #include <stdexcept>
 #include <tuple>
 #include <regex>
+#include <memory>
 #include <sys/types.h>
+#include <sys/select.h>
 
 namespace klp
 {
   namespace ccp
   {
+    class policy_answer_cache;
+
     class user_policy_command
     {
+    private:
+      class _coprocess;
+
     public:
       class cmd_parse_except : public std::exception
       {
@@ -85,6 +92,22 @@ namespace klp
 	instance(const pid_t pid, const int stdout_fd, const int stderr_fd,
 		 std::vector<std::string> &&argv,
 		 std::regex &&re_result) noexcept;
+	instance(_coprocess &cp, std::vector<std::string> &&argv,
+		 std::regex &&re_result) noexcept;
+	instance(std::string &&cached_answer, std::vector<std::string> &&argv,
+		 std::regex &&re_result);
+
+	bool _output_done() const noexcept
+	{ return _stdout_fd == -1 && _stderr_fd == -1; }
+
+	int _add_output_fds(fd_set &readfds, int nfds) const noexcept;
+	void _read_output(const fd_set &readfds);
+	void _reap();
+	void _store_answer();
+
+	void _wait_coprocess();
+	void _check_exit_status(const int status);
+	void _check_result();
 
 	void _process_stdout(_buffer_type &&buf);
 	void _process_stdout_line(_buffer_type::const_iterator line_begin,
@@ -97,6 +120,9 @@ namespace klp
 	pid_t _pid;
 	int _stdout_fd;
 	int _stderr_fd;
+	_coprocess *_cp;
+	bool _from_cache;
+	policy_answer_cache *_cache;
 	std::vector<std::string> _argv;
 	std::regex _re_result;
 
@@ -110,13 +136,50 @@ namespace klp
 	std::string _stderr_output;
       };
 
-      user_policy_command(const std::string &cmd);
+      // In persistent mode, the command gets started only once,
+      // without any extra arguments, and is sent one query per line
+      // on its stdin. Each query is answered with the usual output
+      // lines, terminated by a line containing only "END".
+      //
+      // Batches of one-shot queries get answered by up to max_jobs
+      // concurrently running invocations.
+      //
+      // If given, answers get looked up in and recorded to cache.
+      user_policy_command(const std::string &cmd,
+			  const bool persistent = false,
+			  const unsigned int max_jobs = 1,
+			  policy_answer_cache * const cache = nullptr);
+
+      user_policy_command(user_policy_command &&c) noexcept;
+
+      ~user_policy_command() noexcept;
 
       instance execute(const std::vector<std::string> &extra_args,
 		       char *envp[], std::regex &&re_result) const;
 
+      // Run a whole list of queries and return the waited for
+      // instances in the same order. In persistent mode, the queries
+      // get pipelined rather than answered one round trip at a time.
+      std::vector<instance>
+      execute_batch(const std::vector<std::vector<std::string>> &queries,
+		    char *envp[], const std::regex &re_result) const;
+
     private:
+      static constexpr std::size_t _MAX_PIPELINED_QUERIES = 64;
+
+      // Keeps the number of pipe fds well below FD_SETSIZE.
+      static constexpr unsigned int _MAX_JOBS = 64;
+
+      pid_t _spawn(const std::vector<std::string> &argv, char *envp[],
+		   const int stdin_fd, int &stdout_fd, int &stderr_fd) const;
+
+      _coprocess& _get_coprocess(char *envp[]) const;
+
       std::vector<std::string> _args;
+      bool _persistent;
+      unsigned int _max_jobs;
+      policy_answer_cache *_cache;
+      mutable std::unique_ptr<_coprocess> _cp;
     };
   }
 }